@@ -96,6 +96,7 @@
 #include <time.h>		//MOD RS
 
 #include <ctype.h>		//MOD RS
+#include "modrs.h"		//MOD RS
 
 /***************************************************************************
     TYPE DEFINITIONS
@@ -155,13 +156,13 @@ struct _mame_private
 ***************************************************************************/
 
 /* the active machine */
-static running_machine *global_machine;
+static MM_TLS running_machine *global_machine;		//MOD RS je Emulationsthread
 
 /* the current options */
-static core_options *mame_opts;
+static MM_TLS core_options *mame_opts;				//MOD RS je Emulationsthread
 
 /* started empty? */
-static UINT8 started_empty;
+static MM_TLS UINT8 started_empty;					//MOD RS je Emulationsthread
 
 /* output channels */
 static output_callback_func output_cb[OUTPUT_CHANNEL_COUNT];
@@ -224,8 +225,6 @@ INLINE void eat_all_cpu_cycles(running_machine *machine)
 // Begin of   MOD RS
 //--------------------------------------------------------------------------
 
-#include "modrs.h"
-
 static int isPromoInput(char* move);
 static int isPromoCmd(char *cmd);
 static int isPromoPiece(char p);
@@ -238,17 +237,39 @@ static int CmdFromFEN(running_machine *machine, char * FEN, char * cmd, int forc
 static void addChar(char *str, char first);
 static UINT64 GetTime(void);
 static void clearTC(void);
-static void TimeControl(TC_T *p_tc);
-static int TimeOver(TC_T *p_tc);
+static void TimeControl(running_machine *machine, TC_T *p_tc);
+static int TimeOver(running_machine *machine, TC_T *p_tc);
+static UINT64 TimeUsed(running_machine *machine, TC_T *p_tc);
+static void OvhMoveSent(void);
 static void PrintLevel();
 static void LogProfiler(running_machine *machine);
+static void LogWrite(const char *string, va_list ArgList);
+static void LogDrain(void);
+static int IsFlushLine(const char *cmd);
+static int EpdMaster(core_options *options, int *error);
+static int MatchMaster(core_options *options);
+static int TuneMaster(core_options *options);
+static void EpdResult(const char *move);
+static void StartThreads(void);
+static void ForkServer(running_machine *machine);
+static int ForkConnect(const char *path);
+static void LoadSymbols(const char *module);
+static void StopSearch(running_machine *machine);
+static void PlyAdvance(void);
+static UINT32 SymRead(running_machine *machine, offs_t addr, int size);
+static int SymSquare(int sq, char *field);
+static int SymReadInfo(running_machine *machine, XCMD_INFO_T *info);
+static void EvLatency(EV_STAT_T *stat, attotime start, attotime end);
+static void ProcessEvents(running_machine *machine);
+static void LogEventStat(void);
 static void ProcessDRIVER_START(running_machine *machine);
 static void ProcessSEARCHING(running_machine *machine);
-static void ProcessDRIVER_READY(void);
+static void ProcessPONDERING(running_machine *machine);
+static void ProcessDRIVER_READY(running_machine *machine);
 static void ProcessPARSEINPUT(running_machine *machine);
 static void ProcessSENDCOMMAND(running_machine *machine);
 static void ProcessSPECIALCOMMANDS(void);
-static void ProcessBESTMOVE(void);
+static void ProcessBESTMOVE(running_machine *machine);
 static void ProcessBESTMOVEPROMO(running_machine *machine);
 static void ProcessSPECIALCOMMANDS(void);
 
@@ -258,6 +279,13 @@ static void ProcessSPECIALCOMMANDS(void);
 #if defined linux
 
 #include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <poll.h>
 
 #define Thandle pthread_t
 
@@ -268,56 +296,54 @@ static void ProcessSPECIALCOMMANDS(void);
 
 #define DeleteThread(thread)
 
-#define PMutex(x)                   pthread_mutex_t x=PTHREAD_MUTEX_INITIALIZER
-#define Ehandle(x)                  pthread_cond_t  x=PTHREAD_COND_INITIALIZER
+#define PMutex(x)                   pthread_mutex_t x
+#define Ehandle(x)                  pthread_cond_t  x
 
-#define CreateEventOrCond(x)
+#define CreateEventOrCond(x)		pthread_cond_init(&x,NULL)
+#define CreateCondMutex(x)			pthread_mutex_init(&x,NULL)
 #define SetEventOrCond(x)			pthread_cond_signal(&x)
 
-#define WaitInputProcessed			(pthread_cond_wait(&HInputProcessed, &MutexProcessed)==0 ? TRUE : FALSE)
-
-#define WaitDisplayChanged			(pthread_cond_wait(&HDisplayChanged, &MutexDisplayChanged)==0 ? TRUE : FALSE)
-
 #define Lock(x)						pthread_mutex_lock(&x)
 #define Unlock(x)					pthread_mutex_unlock(&x)
 
 #define LockCondMutex(x)			pthread_mutex_lock(&x)
 #define UnLockCondMutex(x)			pthread_mutex_unlock(&x)
 
-#define WaitTime 12
+#define StrTok(str,delim,save)		strtok_r(str,delim,save)
 
-// Thread Events
+// Warten auf Signal mit Timeout, der Mutex muss gesperrt sein
+// Rueckgabe FALSE bei Timeout
 //
-Ehandle(HInputProcessed);
-Ehandle(HInputAvailable);
-Ehandle(HDisplayChanged);
-
-PMutex(MutexProcessed);
-PMutex(MutexAvailable);
-PMutex(MutexDisplayChanged);
-
-INLINE int WaitInputAvailable(int millisec)
+INLINE int WaitCondTimed(pthread_cond_t *cond, pthread_mutex_t *mutex, int millisec)
 {
 	int ret;
 	struct timeval    tp;
 	struct timespec   abstime;
 
 	if (millisec >= INFINITE)
-		ret=pthread_cond_wait(&HInputAvailable, &MutexAvailable);
+		ret=pthread_cond_wait(cond, mutex);
 	else
 	{		
 		gettimeofday(&tp, NULL);
 		
-		abstime.tv_sec   = tp.tv_sec;;
-		abstime.tv_nsec  = tp.tv_usec * 1000;
-		abstime.tv_nsec +=  millisec * 1000000;
+		abstime.tv_sec   = tp.tv_sec + millisec / 1000;
+		abstime.tv_nsec  = tp.tv_usec * 1000 + (millisec % 1000) * 1000000;
+		if (abstime.tv_nsec >= 1000000000)
+		{
+			abstime.tv_sec++;
+			abstime.tv_nsec -= 1000000000;
+		}
 		
-		ret = pthread_cond_timedwait(&HInputAvailable, &MutexAvailable, &abstime);
+		ret = pthread_cond_timedwait(cond, mutex, &abstime);
 	}
 
 	return (ret==0);
 }
 
+#define WaitCondAvailable(io,time)	WaitCondTimed(&(io)->HInputAvailable, &(io)->MutexAvailable, time)
+#define WaitCondProcessed(io)		pthread_cond_wait(&(io)->HInputProcessed, &(io)->MutexProcessed)
+#define WaitCondOutput(io,time)		WaitCondTimed(&(io)->HOutputAvailable, &(io)->MutexOutput, time)
+
 
 // Windows Threads
 //
@@ -337,10 +363,11 @@ INLINE int WaitInputAvailable(int millisec)
 #define PMutex(x)					int x
 #define Ehandle(x)					HANDLE x
 #define CreateEventOrCond(x)		x=CreateEvent(NULL,FALSE,FALSE,NULL)			//CreateEvent
+#define CreateCondMutex(x)
 #define SetEventOrCond(x)			SetEvent(x)
-#define WaitInputAvailable(time)	(WaitForSingleObject(HInputAvailable,time)== WAIT_OBJECT_0 ? TRUE : FALSE)    //WaitForSingleObject
-#define WaitInputProcessed			(WaitForSingleObject(HInputProcessed,INFINITE)== WAIT_OBJECT_0 ? TRUE : FALSE)//WaitForSingleObject
-#define WaitDisplayChanged			(WaitForSingleObject(HDisplayChanged,INFINITE)== WAIT_OBJECT_0 ? TRUE : FALSE)//WaitForSingleObject
+#define WaitCondAvailable(io,time)	(WaitForSingleObject((io)->HInputAvailable,time)== WAIT_OBJECT_0 ? TRUE : FALSE)    //WaitForSingleObject
+#define WaitCondProcessed(io)		WaitForSingleObject((io)->HInputProcessed,INFINITE)									//WaitForSingleObject
+#define WaitCondOutput(io,time)		(WaitForSingleObject((io)->HOutputAvailable,time)== WAIT_OBJECT_0 ? TRUE : FALSE)   //WaitForSingleObject
 
 
 
@@ -350,32 +377,370 @@ INLINE int WaitInputAvailable(int millisec)
 #define LockCondMutex(mutex)	
 #define UnLockCondMutex(mutex)		
 
-#define WaitTime 1
+#define StrTok(str,delim,save)		strtok_s(str,delim,save)
+
+#endif
+
+// Eingabe-Warteschlange Input Thread -> Main Thread (ein Schreiber, ein Leser)
+// Jede Zeile hat ihren eigenen Platz in der Arena, der Main Thread arbeitet direkt
+// darauf (g_input zeigt auf die aktuelle Zeile), bis InputProcessed den Platz freigibt
+// Die Signale (Events, Cond. Vars) dienen nur zum Aufwecken
+//
+#define IN_QUEUE_SIZE	16						// 2er-Potenz
+#define IN_LINE_MAX		4096
 
-// Thread Events
+// Ausgabe-Warteschlange Main Thread -> Output Thread (ein Schreiber, ein Leser)
+// stdout ist gepuffert, fflush nur nach Zeilen, die die GUI sofort braucht (move, pong, feature, ...)
+// oder wenn OUT_FLUSH_MS nichts mehr kommt
 //
-Ehandle(HInputProcessed);
-Ehandle(HInputAvailable);
-Ehandle(HDisplayChanged);
+#define OUT_QUEUE_SIZE	64						// 2er-Potenz
+#define OUT_LINE_MAX	256
+#define OUT_FLUSH_MS	100
 
-PMutex(MutexProcessed);
-PMutex(MutexAvailable);
-PMutex(MutexDisplayChanged);
+typedef struct out_line_struct
+{
+	int  flush;
+	char line[OUT_LINE_MAX];
+}OUT_LINE_T;
 
-#endif
+// Log Ring Emulationsthread -> Log Thread
+//
+#define LOG_QUEUE_SIZE	1024					// 2er-Potenz
+#define LOG_LINE_MAX	256
+#define LOG_FLUSH_MS	50
+
+typedef struct log_entry_struct
+{
+	osd_ticks_t ticks;
+	char text[LOG_LINE_MAX];
+}LOG_ENTRY_T;
+
+// Ein-/Ausgabe einer Engine, gemeinsam fuer Emulationsthread, Input, Output und Log Thread
+// Laufen mehrere Engines in einem Prozess, hat jede ihren eigenen Kontext (AttachEngineIO)
+// Der Emulationsthread erreicht ihn ueber g_io, die Threads bekommen ihn als Parameter
+//
+typedef struct modrs_io_struct
+{
+	FILE *in;									//Eingabe GUI (stdin)
+	FILE *out;									//Ausgabe GUI (stdout)
+	char logfile[40];
+
+	char in_arena[IN_QUEUE_SIZE][IN_LINE_MAX];
+	volatile INT32 in_head;						//naechster freier Platz	(schreibt nur der Input Thread)
+	volatile INT32 in_tail;						//aelteste Zeile			(schreibt nur der Main Thread)
+
+	OUT_LINE_T out_queue[OUT_QUEUE_SIZE];
+	volatile INT32 out_head;					//naechster freier Platz	(schreibt nur der Main Thread)
+	volatile INT32 out_tail;					//aelteste Zeile			(schreibt nur der Output Thread)
+
+	LOG_ENTRY_T log_queue[LOG_QUEUE_SIZE];
+	volatile INT32 log_head;
+	volatile INT32 log_tail;
+	volatile INT32 log_idle;
+	osd_ticks_t log_start;
+	long log_max;								//max. Groesse Logfile in Byte (-mmlogsize in KB), 0 = unbegrenzt
+
+	Ehandle(HInputProcessed);					//Thread Events
+	Ehandle(HInputAvailable);
+	Ehandle(HOutputAvailable);
+
+	PMutex(MutexProcessed);
+	PMutex(MutexAvailable);
+	PMutex(MutexOutput);
+
+	Thandle in_thread;							//Handles auf die Threads
+	Thandle out_thread;
+	Thandle log_thread;
+	int threads_started;
+
+	volatile int exit_flag;
+}MODRS_IO_T;
+
+static MM_TLS MODRS_IO_T *g_io=NULL;			//Kontext der Engine dieses Emulationsthreads
+static MM_TLS int g_input_taken=FALSE;			//Zeile in_tail vom Main Thread uebernommen
+static MM_TLS char *g_input=NULL;				//aktuelle Eingabe
+
+#define InputQueued(io)		((io)->in_head != (io)->in_tail)
+#define InputFull(io)		((io)->in_head - (io)->in_tail >= IN_QUEUE_SIZE)
+#define InputSlot(io,x)		((io)->in_arena[(x) & (IN_QUEUE_SIZE-1)])
+
+#define OutputQueued(io)	((io)->out_head != (io)->out_tail)
+#define OutputFull(io)		((io)->out_head - (io)->out_tail >= OUT_QUEUE_SIZE)
+
+#define INPUT_DRAIN		8						//Max. Anzahl Eingaben pro Zeitscheibe
+
+static MM_TLS UINT32 g_poll_calls=0;			//Anzahl Abfragen Eingabe
+static MM_TLS osd_ticks_t g_poll_ticks=0;		//Wartezeit (Wall Time) bei Abfragen mit Timeout
+static MM_TLS int g_poll_wait=0;				//Timeout in ms bei Abfrage Eingabe (-mmpollwait), 0 = nicht blockieren
+static int g_epd_mode=FALSE;					//EPD Testlauf aktiv (-mmepd), Eingabe ueber ThreadFuncEpd
+static volatile INT32 g_epd_pong=FALSE;			//pong nach Abbruch einer haengenden Stellung
+static MM_TLS UINT32 g_in_coalesced=0;			//Anzahl zusammengefasster Eingaben (time, otim)
+static MM_TLS UINT32 g_out_dropped=0;			//verworfene Zeilen (Info, Display) bei voller Warteschlange
+
+//------------------------------
+// AttachEngineIO
+//------------------------------
+// Ein-/Ausgabe fuer den aufrufenden Emulationsthread anlegen, vor mame_execute
+// Ohne Aufruf nimmt mame_execute stdin/stdout, logname = Praefix Logfile (NULL = "log_")
+//
+void AttachEngineIO(FILE *in, FILE *out, const char *logname)
+{
+	MODRS_IO_T *io;
+
+	io=(MODRS_IO_T *) calloc(1,sizeof(MODRS_IO_T));
+	if (io==NULL)
+		fatalerror("AttachEngineIO: out of memory");
+
+	io->in=in;
+	io->out=out;
+	strncpy(io->logfile,logname!=NULL ? logname : "log_",sizeof(io->logfile)-16);
+	io->log_idle=TRUE;
+
+	CreateEventOrCond(io->HInputProcessed);
+	CreateEventOrCond(io->HInputAvailable);
+	CreateEventOrCond(io->HOutputAvailable);
+
+	CreateCondMutex(io->MutexProcessed);
+	CreateCondMutex(io->MutexAvailable);
+	CreateCondMutex(io->MutexOutput);
+
+	g_io=io;
+	g_input=io->in_arena[0];
+	g_input_taken=FALSE;
+}
 
-INLINE void InputAvailable(void)
+//------------------------------
+// InputAvailable -> Input Thread
+//------------------------------
+// Zeile InputSlot(io,in_head) ist fertig
+//
+INLINE void InputAvailable(MODRS_IO_T *io)
+{
+	LockCondMutex(io->MutexAvailable);					 
+	atomic_add32(&io->in_head,1);
+	SetEventOrCond(io->HInputAvailable);				 
+    UnLockCondMutex(io->MutexAvailable);				 
+}
+
+//------------------------------
+// WaitInputSpace -> Input Thread
+//------------------------------
+// Warten bis in der Warteschlange Platz ist
+//
+INLINE void WaitInputSpace(MODRS_IO_T *io)
+{
+	LockCondMutex(io->MutexProcessed);					 
+	while (InputFull(io))
+		WaitCondProcessed(io);
+    UnLockCondMutex(io->MutexProcessed);				 
+}
+
+//------------------------------
+// InputRelease -> Main Thread
+//------------------------------
+INLINE void InputRelease(void)
 {
-	LockCondMutex(MutexAvailable);					 
-	SetEventOrCond(HInputAvailable);				 
-    UnLockCondMutex(MutexAvailable);				 
+	LockCondMutex(g_io->MutexProcessed);					 
+	atomic_add32(&g_io->in_tail,1);
+	SetEventOrCond(g_io->HInputProcessed);				 
+    UnLockCondMutex(g_io->MutexProcessed);				 
 }
 
+//------------------------------
+// InputProcessed -> Main Thread
+//------------------------------
+// Nur wenn eine Eingabe uebernommen wurde, mehrfacher Aufruf ist unkritisch
+//
 INLINE void InputProcessed(void)
 {
-	LockCondMutex(MutexProcessed);					 
-	SetEventOrCond(HInputProcessed);				 
-    UnLockCondMutex(MutexProcessed);				 
+	if (!g_input_taken)
+		return;
+
+	g_input_taken=FALSE;
+	InputRelease();
+}
+
+//------------------------------
+// InputSuperseded -> Main Thread
+//------------------------------
+// time bzw. otim wird durch eine spaetere Zeile ersetzt, wenn dazwischen nur time/otim liegen
+//
+static int InputSuperseded(const char *line)
+{
+	INT32 i;
+	char *next;
+
+	if (strncmp(line,"time ",5) && strncmp(line,"otim ",5))
+		return FALSE;
+
+	for (i=g_io->in_tail+1; i!=g_io->in_head; i++)
+	{
+		next=InputSlot(g_io,i);
+
+		if (strncmp(next,"time ",5) && strncmp(next,"otim ",5))
+			return FALSE;
+
+		if (!strncmp(next,line,5))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+//------------------------------
+// InputStopQueued -> Main Thread
+//------------------------------
+// Suchabbruch (?, stop, exit, quit) hinter der aktuellen Zeile in der Warteschlange ?
+//
+static int InputStopQueued(void)
+{
+	INT32 i;
+	char *next;
+
+	for (i=g_io->in_tail+1; i!=g_io->in_head; i++)
+	{
+		next=InputSlot(g_io,i);
+
+		if (!strcmp(next,"?") || !strcmp(next,"stop") ||
+			!strcmp(next,"exit") || !strcmp(next,"quit"))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+//------------------------------
+// WaitInputAvailable -> Main Thread
+//------------------------------
+// millisec = 0 -> nur Abfrage, die Emulation wird nicht angehalten
+//
+INLINE int WaitInputAvailable(int millisec)
+{
+	osd_ticks_t start;
+
+	g_poll_calls++;
+
+	if (!g_input_taken && !InputQueued(g_io) && millisec != 0)
+	{
+		start=osd_ticks();
+
+		LockCondMutex(g_io->MutexAvailable);
+		while (!InputQueued(g_io))
+		{
+			if (!WaitCondAvailable(g_io,millisec) && millisec < INFINITE)
+				break;
+		}
+		UnLockCondMutex(g_io->MutexAvailable);
+
+		g_poll_ticks+=osd_ticks()-start;
+	}
+
+	if (!g_input_taken && InputQueued(g_io))
+	{
+		g_input=InputSlot(g_io,g_io->in_tail);
+
+		while (InputSuperseded(g_input))				//Ueberholte time/otim verwerfen
+		{
+			LogDebug("GUI    Input : %s ->coalesced\n",g_input);
+			InputRelease();
+			g_input=InputSlot(g_io,g_io->in_tail);
+			g_in_coalesced++;
+		}
+
+		g_input_taken=TRUE;
+	}
+
+	return g_input_taken;
+}
+
+//------------------------------
+// OutputLine -> Main Thread
+//------------------------------
+// flush=FALSE: Zeile wird bei voller Warteschlange verworfen
+// flush=TRUE : warten bis Platz ist, danach sofort fflush
+//
+static void OutputLine(const char *line, int flush)
+{
+	OUT_LINE_T *out;
+
+	while (OutputFull(g_io))
+	{
+		if (!flush || !g_io->threads_started)		//Fork Server: ohne Output Thread nicht warten
+		{
+			g_out_dropped++;
+			return;
+		}
+		osd_sleep(osd_ticks_per_second()/1000);
+	}
+
+	out=&g_io->out_queue[g_io->out_head & (OUT_QUEUE_SIZE-1)];
+	strncpy(out->line,line,OUT_LINE_MAX-1);
+	out->line[OUT_LINE_MAX-1]='\0';
+	out->flush=flush;
+
+	LockCondMutex(g_io->MutexOutput);					 
+	atomic_add32(&g_io->out_head,1);
+	SetEventOrCond(g_io->HOutputAvailable);				 
+    UnLockCondMutex(g_io->MutexOutput);				 
+}
+
+//------------------------------
+// OutputDrain -> Main Thread
+//------------------------------
+// Warten bis alle Zeilen geschrieben sind (Programmende)
+//
+static void OutputDrain(void)
+{
+	if (g_io->out==NULL)						//Match: Schiedsrichter liest nicht mehr
+		return;
+
+	while (OutputQueued(g_io))
+		osd_sleep(osd_ticks_per_second()/1000);
+
+	fflush(g_io->out);
+}
+
+//------------------------------
+// Output Thread
+//------------------------------
+THREAD_PROC_RET ThreadFuncOutput(void* data)
+{
+	MODRS_IO_T *io=(MODRS_IO_T *) data;
+	OUT_LINE_T *out;
+	int pending=FALSE;							//geschriebene, aber noch nicht geflushte Zeilen
+
+	for (;;)
+	{
+		LockCondMutex(io->MutexOutput);
+		while (!OutputQueued(io))
+		{
+			if (!WaitCondOutput(io,pending ? OUT_FLUSH_MS : INFINITE) && pending)
+				break;
+		}
+		UnLockCondMutex(io->MutexOutput);
+
+		if (!OutputQueued(io))					//Timeout -> Rest ausgeben
+		{
+			fflush(io->out);
+			pending=FALSE;
+			continue;
+		}
+
+		out=&io->out_queue[io->out_tail & (OUT_QUEUE_SIZE-1)];
+		fputs(out->line,io->out);
+
+		if (out->flush)
+		{
+			fflush(io->out);
+			pending=FALSE;
+		}
+		else
+			pending=TRUE;
+
+		atomic_add32(&io->out_tail,1);
+	}
+
+	return 0;
 }
 
 #define WHITE	0
@@ -403,11 +768,11 @@ INLINE void InputProcessed(void)
 
 // Globales Debug Flag
 //
-char g_debug=FALSE;
+MM_TLS char g_debug=FALSE;
 
 // 7-Segement Anzeige
 //
-char g_display[10]= "    ";
+MM_TLS char g_display[10]= "    ";
 
 // Umsetzung von 7-Segement data in lesbare Ausgabe
 //
@@ -434,61 +799,74 @@ char g_segment[128] = {
 
 // Statusflag
 //
-int g_state;
+MM_TLS int g_state;
 
 // Fehlerflag (Display zeigt Err)
 //
-int g_error;
+MM_TLS int g_error;
 
 // Globale Variabeln Wartezeiten, abhnig von Modul
 //
-int g_bestmoveWait;
-int g_inputWait;
-int g_promoWait;
-int g_specialWait;
-int g_inputTimeout;
+MM_TLS int g_bestmoveWait;
+MM_TLS int g_inputWait;
+MM_TLS int g_promoWait;
+MM_TLS int g_specialWait;
+MM_TLS int g_inputTimeout;
 
 // Zhler Wartezeit (Wartezeit nach Eingabe Befehl,Tastendruck)
 //
-unsigned int g_waitCnt=0;
+MM_TLS unsigned int g_waitCnt=0;
 
 // Flags zur Erkennung der Verabeitung der Eingabe
 //
-int  g_displayChanged=TRUE;
-int  g_portIsReady=TRUE;
+MM_TLS int  g_displayChanged=TRUE;
+MM_TLS int  g_portIsReady=TRUE;
 
-// Logfile
+// Logfile (Name und Ring im Kontext g_io)
 //
-char g_logfile[20]="log_";
-int g_mmlog=FALSE;
+MM_TLS int g_mmlog=FALSE;
+static MM_TLS UINT32 g_log_dropped=0;
 
 //Flag, welcher Typ Emulation (z.B. MM, GLASGOW,...)
 //
-int g_emu;
+MM_TLS int g_emu;
 
 //Flag, welche Tastenbelegung
 //
-int g_keys;
+MM_TLS int g_keys;
 
 // Flag maximale Geschwindigkeit
 //
-int g_unlimited=TRUE;
+MM_TLS int g_unlimited=TRUE;
 
 // Taktfrequenz mit der die Emulation aktuell luft (Kann ber -mmclock gendert werden
 //
-int g_clock;
+MM_TLS int g_clock;
 
 // Orginal Taktfrequenz des jeweiligen Moduls
 //
-int g_org_clock;
+MM_TLS int g_org_clock;
 
 // Profilerausgabe in Logfile
 //
-int g_profiler;
+MM_TLS int g_profiler;
 
 // Flag Emulation laeuft als Xboard/Enigne
 //
-int g_xboard_mode;
+MM_TLS int g_xboard_mode;
+
+// Flag Zuege direkt ins RAM schreiben (-mminject)
+//
+MM_TLS int g_inject;
+static MM_TLS int g_injected=FALSE;				//Zug seit new/setboard im RAM, Zugliste des ROMs unvollstaendig
+
+// Flag setboard direkt ins RAM schreiben (-mmsetboard)
+//
+static MM_TLS int g_setboard;
+
+// Schnittstelle zum Treiber (Zugeingabe ueber RAM)
+//
+MM_TLS EMU_BRIDGE_T g_bridge;
 
 
 // Sammel von Daten (Performanceanalyse)
@@ -497,73 +875,194 @@ int g_xboard_mode;
 
 // Zeitberechnung (Ermittlung der Geschwindigkeit der Emulation)
 //
-static int g_option_tc_delay;
-static int g_start_time_sc;
-static int g_end_time_sc;
-static int g_time_per_sec;
-static int g_tc_delay;			
-static float g_time_corr;		//Faktor fr Zeitkorrektur
-
-//Eingabe, Commandostring
+static MM_TLS int g_option_tc_delay;
+static MM_TLS int g_start_time_sc;
+static MM_TLS int g_end_time_sc;
+static MM_TLS int g_time_per_sec;
+static MM_TLS int g_tc_delay;			
+static MM_TLS float g_time_corr;		//Faktor fr Zeitkorrektur
+
+//Commandostring
 //
-static char g_input[65536];
-static char g_cmd[65536];
+static MM_TLS char g_cmd[65536];
 
-static char *cmd1;			//Pointer zum Aufsplitten des GUI Kommandos
-static char *nextcmd;
+static MM_TLS char *cmd1;			//Pointer zum Aufsplitten des GUI Kommandos
+static MM_TLS char *nextcmd;
+static MM_TLS char *g_cmd_tok;		//Position StrTok (strtok ist nicht reentrant)
 
 // Lnge,index des Commandostrings
 //
-static int  g_cmd_inx=0;
-static int  g_cmd_len=0;
+static MM_TLS int  g_cmd_inx=0;
+static MM_TLS int  g_cmd_len=0;
 
 // letzter ausgefhrter Befehl
 //
-static char g_last_cmd;
+static MM_TLS char g_last_cmd;
 
 // Zhler Prfung ob Consoleneingabe vorhanden
 //
-static int g_InputCheck;
+static MM_TLS int g_InputCheck;
 
 //  Startwert Zhler Prfung ob Consoleneingabe vorhanden
 //
-static int g_InputCheckStart;
+static MM_TLS int g_InputCheckStart;
 
 // Zhler Prfung Zeit
 //
-static int g_TimeCheck=TIMECHECK;
+static MM_TLS int g_TimeCheck=TIMECHECK;
 
 // CPU Takt bei Eingabe
 //
-static int g_input_clock;
+static MM_TLS int g_input_clock;
 
 // Speedfaktor bei Eingabe
 //
-static int g_input_speed;
+static MM_TLS int g_input_speed;
 
 // Flag Suche soll gestartet werden
 //
-static int g_start_search;
+static MM_TLS int g_start_search;
 
 // Flag Suche soll abgebrochen werden
 //
-static int g_break_search;
+static MM_TLS int g_break_search;
+
+// Suchabbruch (StopSearch) und Frist bis zum Zug (-mmstopdeadline, 0 = aus)
+//
+static MM_TLS int g_stop_pending=FALSE;			//Abbruch gesendet, Zug noch nicht da
+static MM_TLS attotime g_stop_time;				//Zeitpunkt Abbruch in Emulatorzeit
+static MM_TLS UINT64 g_stop_wall;					//Zeitpunkt Abbruch in ms
+static MM_TLS UINT32 g_stop_deadline=0;
+static MM_TLS char g_stop_move[10];				//Nach Ablauf der Frist gesendet, das ROM rechnet noch
+static MM_TLS UINT32 g_stop_forced=0;
+static MM_TLS UINT32 g_stop_fixed=0;				//ROM hat anders gezogen -> Zug per Tasten korrigiert
+static MM_TLS int g_cmd_internal=FALSE;			//Tastenfolge ohne Eingabezeile, kein InputProcessed
+
+// Zustand nach dem Start (-mmsnapshot 1 = pro Prozess, 2 = dauerhaft in snap_<modul>.sta)
+// "new" laedt ihn statt soft_reset, mit 2 entfaellt beim naechsten Start auch der Bootvorgang
+//
+#define SNAP_FILE		"snap_%s.sta"
+#define SNAP_TMP_FILE	"snap_%s_%08x.tmp"
+#define SNAP_BOOT_MS	2000				//Mindestdauer Bootvorgang in Emulatorzeit
+
+static MM_TLS int g_snapshot=0;
+static MM_TLS char g_snap_name[60];
+static MM_TLS char g_snap_path[260];			//Zum Loeschen bei -mmsnapshot 1
+static MM_TLS char g_snap_display[10];			//Anzeige beim Sichern
+static MM_TLS int g_snap_valid=FALSE;
+static MM_TLS int g_snap_owner=FALSE;
+static MM_TLS UINT32 g_snap_tag=0;				//Eindeutiger Teil der Dateinamen je Prozess
+
+// Zustand je Halbzug fuer undo/remove (-mmplysnaps Eintraege im Ring, 0 = aus)
+//
+#define PLY_FILE		"snap_%s_%08x_p%02d.tmp"
+#define PLY_SNAPS_MAX	64
+
+typedef struct
+{
+	int ply;									//Halbzug, -1 = leer
+	int gen;									//Ungueltig nach Aenderung Stufe, Stellung
+	int force;									//xcmd_force_mode beim Sichern
+	char display[10];
+	char name[60];
+	char path[260];								//Zum Loeschen am Ende
+} PLY_SNAP_T;
+
+static MM_TLS int g_plysnaps=0;
+static MM_TLS PLY_SNAP_T g_ply_snap[PLY_SNAPS_MAX];
+static MM_TLS int g_ply=0;						//Aktueller Halbzug seit new/setboard
+static MM_TLS int g_ply_gen=0;
+static MM_TLS int g_ply_dirty=FALSE;				//Tasten gesendet, Zustand noch nicht gesichert
+
+#define PLY_SNAP_WAIT	60							//Modul nicht bereit -> Halbzug nach n Ticks nicht sichern
+
+// Pondern bei mmunlimited (-mmponder, aktiv nach "hard"): erwartete Antwort aus der PV auf Zeit des Gegners
+// rechnen, bei Treffer weiter, sonst Zustand nach dem eigenen Zug laden (Ring der Halbzuege)
+//
+static MM_TLS int g_ponder_option=FALSE;
+static MM_TLS int g_ponder=FALSE;
+static MM_TLS int g_ponder_pending=FALSE;			//Nach Bestmove, Start sobald der Halbzug gesichert ist
+static MM_TLS int g_ponder_start=FALSE;			//Tastenfolge Antwortzug -> PONDERING statt SEARCHING
+static MM_TLS int g_ponder_ended=FALSE;			//Das ROM hat die Suche beim Pondern beendet
+static MM_TLS char g_ponder_move[10];
+static MM_TLS char g_ponder_display[10];			//Display nach Loslassen von ENT, leer = Taste noch gedrueckt
+static MM_TLS UINT32 g_ponder_hits=0;
+static MM_TLS UINT32 g_ponder_misses=0;
+
+// UCI Modus (nach "uci"): position liefert die ganze Partie, eingegeben werden nur die neuen Zuege
+//
+#define UCI_MOVES_MAX	1024
+
+static MM_TLS int g_uci_mode=FALSE;
+static MM_TLS char g_uci_fen[100];				//Ausgangsstellung, leer = startpos
+static MM_TLS char g_uci_moves[UCI_MOVES_MAX][6];
+static MM_TLS int g_uci_total=0;					//Zuege aus dem letzten position
+static MM_TLS int g_uci_count=0;					//davon im Modul eingegeben (= g_ply)
+static MM_TLS int g_uci_ponder=FALSE;			//go ponder: Zeitkontrolle erst mit ponderhit
+static MM_TLS TC_T g_uci_tc;
+
+// Virtuelle Uhr (-mmvclock): Zeitvorgaben der GUI in Emulatorzeit, Abbruch ueber Timer
+//
+static MM_TLS int g_vclock=FALSE;
+static MM_TLS emu_timer *g_vclock_timer=NULL;		//Angelegt in init_machine
+
+// Gemessener Zeitverbrauch Zugein/ausgabe pro Modul (tc_<modul>.txt), ersetzt g_tc_delay
+//
+#define OVH_MIN_SAMPLES	3					//Ab dann Messwerte statt g_tc_delay
+#define OVH_ALPHA		0.2f				//Gewicht neuer Messwert
+
+static MM_TLS char g_ovh_file[40];
+static MM_TLS float g_ovh_in=0;					//Eingang GUI Zug -> Start Suche (ms)
+static MM_TLS float g_ovh_out=0;					//Ende Suche -> Ausgabe move (ms)
+static MM_TLS float g_ovh_dev=0;					//mittlere Abweichung Summe
+static MM_TLS UINT32 g_ovh_samples=0;
+static MM_TLS UINT64 g_ovh_t_input=0;				//Zeitpunkte der laufenden Messung
+static MM_TLS INT32 g_ovh_pending_in=-1;
+static MM_TLS UINT64 g_ovh_t_end=0;
+
+// Feste Arbeit pro Zug in CPU Zyklen (cycles N, go cycles N, nps N)
+//
+static MM_TLS UINT64 g_cycles_fixed=0;				//Zyklen pro Zug, 0 = aus
+static MM_TLS UINT32 g_nps=0;						//Zyklen pro Sekunde Zugzeit, 0 = aus
+static MM_TLS UINT64 g_cycle_end;					//Zyklenstand Ende der Suche
+static MM_TLS int g_cycle_budget=FALSE;			//Suche laeuft mit Zyklenvorgabe
+static MM_TLS emu_timer *g_cycle_timer=NULL;		//Angelegt in init_machine
 
 // Flag Level 9 = Unendliche Suche ist eingeschaltet
 //
-static int g_level9;
+static MM_TLS int g_level9;
 
 // Flag wiederholen Tastendruck gedrckt
 //
-static int g_repeat_input;
+static MM_TLS int g_repeat_input;
 
 // Name des Moduls
 //
-static char g_myname[30];
+static MM_TLS char g_myname[30];
 
 // Zeit f Performance messung beim Starten
 //
-static int g_per_wait;
+static MM_TLS int g_per_wait;
+
+// Kalibrierung aus calib.txt (Schluessel Modul, Takt, Build, CPU), Pruefung waehrend der ersten Suche
+//
+#define CALIB_FILE		"calib.txt"
+#define CALIB_WAIT		600					//Zaehler wie Messung beim Start
+#define CALIB_DRIFT		10					//Abweichung in % -> Cache neu schreiben
+
+static MM_TLS char g_calib_key[12];
+static MM_TLS int g_calib_cached=FALSE;			//g_time_per_sec aus dem Cache, noch nicht geprueft
+static MM_TLS int g_calib_tc_delay;				//g_tc_delay vor der Korrektur
+static MM_TLS UINT64 g_calib_start=0;
+static MM_TLS UINT64 g_calib_last;
+static MM_TLS unsigned int g_calib_cnt;
+
+// Handshake Wartezeiten je Modul (hs_<modul>.txt), ermittelt mit -mmtune
+//
+#define HS_FILE			"hs_%s.txt"
+
+static MM_TLS int g_hs_default[5];					//Werte der Modultabelle
+MM_TLS unsigned int g_hs_fail=0;					//Fehlende Displaybestaetigungen seit der letzten Abfrage
 
 // Feldnamen 0=a8, 63=h1
 //
@@ -577,112 +1076,151 @@ static const char g_fields[64][3] = {	"a8","b8","c8","d8","e8","f8","g8","h8",
 										"a1","b1","c1","d1","e1","f1","g1","h1" };
 // gefunder Zug nach Suche
 //
-static char g_bestmove[10];
+static MM_TLS char g_bestmove[10];
 
 // Rckgabewert von WaitInputAvailable
 //
-static int g_ret;
+static MM_TLS int g_ret;
 
 // Xboard Protokol -> Kommandostrings									
 //
 static  char feature_string[100]="feature sigint=0 ping=1 setboard=1 color=0 done=1  myname=\"%s\" \n";
-static  char feature_string_send[100];
-static  char xboardfen[200];
-static  char xboardstring[30];
-static  int  xboardSTtime;
-
-static  char xcmd_st3[20]; 
-static  char xcmd_st5[20]; 
-static  char xcmd_st10[20]; 
-static  char xcmd_st20[20]; 
-static  char xcmd_st60[20]; 
-static  char xcmd_st120[20];
-static  char xcmd_st360[20];
-static  char xcmd_st600[20];
-static  char xcmd_st720[20];
-
-static  char xcmd_level40_2[20];
-static  char xcmd_level0_5[20];
-static  char xcmd_level0_10[20];
-static  char xcmd_level0_15[20];
-static  char xcmd_level0_30[20];
-static  char xcmd_level0_60[20];
-static  char xcmd_lev9[10];
-
-static  char xcmd_analyze[10];
-static  char xcmd_undo[10];
-static  char xcmd_remove[10];
-static  char xcmd_setboard[10];
-static  char xcmd_setboard_col_w[10];
-static  char xcmd_setboard_col_b[10];
-static  char xcmd_leave_force[10];
-static  char xcmd_roll_diplay[10];
-static  char xcmd_show_promo[10];
-static  char xcmd_promo_q[2]; 
-static  char xcmd_promo_r[2];
-static  char xcmd_promo_b[2];
-static  char xcmd_promo_n[2];
-
-static  char xcmd_force[10];
-static  int xcmd_force_mode;
+static MM_TLS char feature_string_send[100];
+static  char uci_string[200]="id name %s\nid author MESS Mephisto, MOD RS\noption name Ponder type check default false\nuciok\n";
+static MM_TLS char uci_string_send[200];
+static MM_TLS char xboardfen[200];
+static MM_TLS char xboardstring[30];
+static MM_TLS int  xboardSTtime;
+
+static MM_TLS char xcmd_st3[20]; 
+static MM_TLS char xcmd_st5[20]; 
+static MM_TLS char xcmd_st10[20]; 
+static MM_TLS char xcmd_st20[20]; 
+static MM_TLS char xcmd_st60[20]; 
+static MM_TLS char xcmd_st120[20];
+static MM_TLS char xcmd_st360[20];
+static MM_TLS char xcmd_st600[20];
+static MM_TLS char xcmd_st720[20];
+
+static MM_TLS char xcmd_level40_2[20];
+static MM_TLS char xcmd_level0_5[20];
+static MM_TLS char xcmd_level0_10[20];
+static MM_TLS char xcmd_level0_15[20];
+static MM_TLS char xcmd_level0_30[20];
+static MM_TLS char xcmd_level0_60[20];
+static MM_TLS char xcmd_lev9[10];
+
+static MM_TLS char xcmd_analyze[10];
+static MM_TLS char xcmd_undo[10];
+static MM_TLS char xcmd_remove[10];
+static MM_TLS char xcmd_setboard[10];
+static MM_TLS char xcmd_setboard_col_w[10];
+static MM_TLS char xcmd_setboard_col_b[10];
+static MM_TLS char xcmd_leave_force[10];
+static MM_TLS char xcmd_roll_diplay[10];
+static MM_TLS char xcmd_show_promo[10];
+static MM_TLS char xcmd_promo_q[2]; 
+static MM_TLS char xcmd_promo_r[2];
+static MM_TLS char xcmd_promo_b[2];
+static MM_TLS char xcmd_promo_n[2];
+
+static MM_TLS char xcmd_force[10];
+static MM_TLS int xcmd_force_mode;
 
 // Infoanzeige
 //
-static  XCMD_INFO_T xcmd_info;
-static  char xcmd_info_string[50];
-
-static  int ix;
-static  char g_info[7][10];
-static  char g_save_info[10];
-static  int g_info_index=0;
-static  int g_info_start=FALSE;
-static  int g_send_info=FALSE;
-static  int g_rollDisplay=FALSE;
-static  int g_rollDisplay_exits=FALSE;
+static MM_TLS XCMD_INFO_T xcmd_info;
+static MM_TLS char xcmd_info_string[80];
+
+static MM_TLS int ix;
+static MM_TLS char g_info[7][10];
+static MM_TLS char g_save_info[10];
+static MM_TLS int g_info_index=0;
+static MM_TLS int g_info_start=FALSE;
+static MM_TLS int g_send_info=FALSE;
+static MM_TLS int g_rollDisplay=FALSE;
+static MM_TLS int g_rollDisplay_exits=FALSE;
 
 // Struktur Zeitkontrolle
 //
-static  TC_T g_tc;
+static MM_TLS TC_T g_tc;
+
+// Ereignis-Warteschlange Treiber -> Bridge
+//
+static MM_TLS EMU_EVENT_T g_ev_queue[EV_QUEUE_SIZE];
+static MM_TLS UINT32 g_ev_head=0;
+static MM_TLS UINT32 g_ev_tail=0;
+
+static MM_TLS int g_search_ended=FALSE;			//Suche beendet, warten bis das Display stabil ist
+static MM_TLS int g_ev_end_valid=FALSE;			//Zeitpunkt Ende Suche gueltig
+static MM_TLS attotime g_ev_search_end;			//Zeitpunkt Ende Suche
+static MM_TLS attotime g_ev_display;				//Zeitpunkt letzte Displayaenderung
+static MM_TLS int g_ev_key_pending=FALSE;			//Taste gedrueckt, warten auf Displayaenderung
+static MM_TLS attotime g_ev_key_time;				//Zeitpunkt Tastendruck
+static MM_TLS UINT32 g_settle_us;					//Display stabil nach us (-mmsettle), 0 = aus
+
+static MM_TLS EV_STAT_T g_ev_stat_bm;				//Ende Suche -> Bestmove
+static MM_TLS EV_STAT_T g_ev_stat_key;			//Tastendruck -> Displayaenderung
+static MM_TLS EV_STAT_T g_ev_stat_scan;			//Tastendruck -> losgelassen (-mmkeyscans)
+static MM_TLS EV_STAT_T g_ev_stat_stop;			//Abbruch Suche -> Bestmove
+
+// Virtuelles Tastenfeld (-mmkeyscans): Tasten aus der Warteschlange werden nach g_keyscans Abfragen
+// ihrer Zeile durch das ROM losgelassen, die naechste folgt nach g_keyscans Abfragen ohne Taste
+// 0 = Handshake im Treiber ueber Display bzw. g_inputTimeout
+//
+#define KEYPAD_IDLE			0
+#define KEYPAD_PRESSED		1
+#define KEYPAD_GAP			2
+
+MM_TLS int g_keyscans=0;
+static MM_TLS EMU_KEY_T g_keypad_queue[KEYPAD_QUEUE_SIZE];
+static MM_TLS UINT32 g_keypad_head=0;
+static MM_TLS UINT32 g_keypad_tail=0;
+static MM_TLS int g_keypad_phase=KEYPAD_IDLE;
+static MM_TLS int g_keypad_scans;
+static MM_TLS attotime g_keypad_time;				//Zeitpunkt Tastendruck
+
+// Symboltabelle RAM-Adressen
+//
+MM_TLS EMU_SYMBOLS_T g_sym;
 
 // Seite am Zug
 //
-static  int g_side=WHITE;
+static MM_TLS int g_side=WHITE;
 
 // Quit,Exit
 //
-static int exit_flag=FALSE;
 
 //------------------------------
 // Input Thread
 //------------------------------
 THREAD_PROC_RET ThreadFuncCheckInput(void* data)
 {
-
+	MODRS_IO_T *io=(MODRS_IO_T *) data;
 	char *rc;
 	char *last;
+	char *line;
 
-	while (!exit_flag )
+	while (!io->exit_flag )
 	{
-		rc=fgets(g_input,65536,stdin);
+		WaitInputSpace(io);						//Warteschlange voll -> warten
+
+		line=InputSlot(io,io->in_head);
+
+		rc=fgets(line,IN_LINE_MAX,io->in);
 		if (rc==NULL){	
 			printf("Error fgets\n");
 			break;
 		}
 
-			last=strchr(g_input, '\n');
+			last=strchr(line, '\n');
 			if (last)
 				*last='\0';
 
-		{
-			InputAvailable();
-
-			if (!WaitInputProcessed)
-				printf("Error WaitInputAProcessed\n");
-
-		}
+		InputAvailable(io);						//Main Thread kann die Zeile lesen, der Input Thread liest weiter
 	}//End while
 
-	return((THREAD_PROC_RET_TYPE)data);
+	return 0;
 }
 //------------------------------
 // PrintState
@@ -754,100 +1292,288 @@ int TestMove( char* move)
 //------------------------------
 void Log(const char *string, ...)
 {
-	FILE *op;
-	time_t t;
-	char t_buff[128];
-	char buffer[4096];
 	va_list ArgList;
 
 	if (!g_mmlog)
 		return;
 
 	va_start (ArgList, string);    
-	vsprintf (buffer, string, ArgList);
+	LogWrite(string, ArgList);
 	va_end (ArgList);
-
-	time(&t);
-	strftime(t_buff, 128,"%d %b %Y %X",localtime (&t));
-
-	op = fopen(g_logfile, "a");
-	fprintf(op,"%s - %s",t_buff,buffer);
-
-	fclose(op);
 }
 //------------------------------
 // PrintAndLog                                           
 //------------------------------
 void PrintAndLog(const char *string, ...)
 {
-	FILE *op;
-	time_t t;
-	char t_buff[128];
 	char buffer[4096];
 	va_list ArgList;
 
 	va_start (ArgList, string);    
-	vsprintf (buffer, string, ArgList);
+	vsnprintf (buffer, sizeof(buffer), string, ArgList);
 	va_end (ArgList);
 
 	if (g_mmlog)
-	{
-		time(&t);
-		strftime(t_buff, 128,"%d %b %Y %X",localtime (&t));
+		Log("%s",buffer);
 
-		op = fopen(g_logfile, "a");
-		fprintf(op,"%s - %s",t_buff,buffer);
+	OutputLine(buffer,FALSE);
+}
 
-		fclose(op);
+//------------------------------
+// LogWrite                                           
+//------------------------------
+// Nachricht in den Ring schreiben (nur Emulationsthread), bei vollem Ring verwerfen
+// Zeitstempel osd_ticks (monoton), Umrechnung erst im Log Thread
+//
+static void LogWrite(const char *string, va_list ArgList)
+{
+	LOG_ENTRY_T *entry;
+
+	if (g_io->log_head - g_io->log_tail >= LOG_QUEUE_SIZE)
+	{
+		g_log_dropped++;
+		return;
 	}
 
-	printf("%s",buffer);
+	entry=&g_io->log_queue[g_io->log_head & (LOG_QUEUE_SIZE-1)];
+	entry->ticks=osd_ticks();
+	if (vsnprintf(entry->text, LOG_LINE_MAX, string, ArgList) >= LOG_LINE_MAX)
+		entry->text[LOG_LINE_MAX-2]='\n';				//gekuerzt
+
+	atomic_add32(&g_io->log_head,1);
 }
 
 //------------------------------
-// SendToGUI 
+// LogOpen                                           
 //------------------------------
-void SendToGUI(char* cmd)
+static FILE *LogOpen(MODRS_IO_T *io)
 {
-	printf("%s",cmd);
-	Log("ENGINE Output: %s",cmd);
+	FILE *op;
+	time_t t;
+	struct tm tm;
+	char t_buff[128];
+
+	op = fopen(io->logfile, "a");
+	if (op==NULL)
+		return NULL;
+
+	time(&t);
+#if defined linux
+	localtime_r(&t,&tm);						//mehrere Log Threads im Prozess
+#else
+	localtime_s(&tm,&t);
+#endif
+	strftime(t_buff, 128,"%d %b %Y %X",&tm);
+	fprintf(op,"%s - Log started (time in s since start)\n",t_buff);
+
+	return op;
 }
+
 //------------------------------
-// GetKeycodeGlasgow
+// LogRotate                                           
 //------------------------------
-static EMU_KEY_T *GetKeycodeGlasgow(char inp)
+// Logfile zu gross -> umbenennen in <logfile>.1 und neu anfangen
+//
+static FILE *LogRotate(MODRS_IO_T *io, FILE *op)
 {
-	static EMU_KEY_T keycode;
-	switch (inp)
-	{
+	char oldfile[48];
 
-	case	'a':
-		strcpy(keycode.name,"LINE0");
-		keycode.data=32;
-		return (&keycode);
+	fclose(op);
 
-	case	'b':
-		strcpy(keycode.name,"LINE0");
-		keycode.data=128;
-		return (&keycode);
+	sprintf(oldfile,"%s.1",io->logfile);
+	remove(oldfile);
+	rename(io->logfile,oldfile);
 
-	case	'c':
-		strcpy(keycode.name,"LINE0");
-		keycode.data=4;
-		return (&keycode);
+	return LogOpen(io);
+}
 
-	case	'd':
-		strcpy(keycode.name,"LINE0");
-		keycode.data=16;
-		return (&keycode);
+//------------------------------
+// Log Thread
+//------------------------------
+// Haelt das Logfile offen und schreibt den Ring weg
+//
+THREAD_PROC_RET ThreadFuncLog(void* data)
+{
+	MODRS_IO_T *io=(MODRS_IO_T *) data;
+	FILE *op=NULL;
+	LOG_ENTRY_T *entry;
+	osd_ticks_t tps=osd_ticks_per_second();
 
-   	case	'e':
-		strcpy(keycode.name,"LINE1");
-		keycode.data=1;
-		return (&keycode);
+	for (;;)
+	{
+		if (io->log_head == io->log_tail)
+		{
+			if (op!=NULL)
+				fflush(op);
+			io->log_idle=TRUE;
+			osd_sleep(tps*LOG_FLUSH_MS/1000);
+			continue;
+		}
+		io->log_idle=FALSE;
 
-   	case	'f':
-		strcpy(keycode.name,"LINE0");
+		if (op==NULL)
+			op=LogOpen(io);
+
+		entry=&io->log_queue[io->log_tail & (LOG_QUEUE_SIZE-1)];
+
+		if (op!=NULL)
+		{
+			fprintf(op,"%10.6f - %s",(double) (entry->ticks-io->log_start)/tps,entry->text);
+
+			if (io->log_max && ftell(op) > io->log_max)
+				op=LogRotate(io,op);
+		}
+
+		atomic_add32(&io->log_tail,1);
+	}
+
+	return 0;
+}
+
+//------------------------------
+// LogDrain                                           
+//------------------------------
+// Warten bis alles geschrieben ist (Programmende)
+//
+static void LogDrain(void)
+{
+	if (g_log_dropped)
+		Log("Log: %u messages dropped\n",g_log_dropped);
+
+	while (g_io->log_head != g_io->log_tail || !g_io->log_idle)
+		osd_sleep(osd_ticks_per_second()/1000);
+}
+
+//------------------------------
+// LogDrainDirect                                           
+//------------------------------
+// Ohne Log Thread (Fork Server): Ring direkt ins Logfile schreiben
+//
+static void LogDrainDirect(MODRS_IO_T *io)
+{
+	FILE *op;
+	LOG_ENTRY_T *entry;
+	osd_ticks_t tps=osd_ticks_per_second();
+
+	if (io->log_head == io->log_tail)
+		return;
+
+	op=LogOpen(io);
+
+	while (io->log_head != io->log_tail)
+	{
+		entry=&io->log_queue[io->log_tail & (LOG_QUEUE_SIZE-1)];
+		if (io->log_start==0)
+			io->log_start=entry->ticks;
+
+		if (op!=NULL)
+			fprintf(op,"%10.6f - %s",(double) (entry->ticks-io->log_start)/tps,entry->text);
+
+		atomic_add32(&io->log_tail,1);
+	}
+
+	if (op!=NULL)
+		fclose(op);
+}
+
+//------------------------------
+// SendToGUI 
+//------------------------------
+void SendToGUI(char* cmd)
+{
+	if (g_uci_mode && (!strncmp(cmd,"resign",6) || !strncmp(cmd,"1/2-1/2",7)) )	//UCI kennt nur bestmove -> Nullzug
+	{
+		Log("ENGINE Result: %s",cmd);
+		cmd=(char *)"bestmove 0000\n";
+	}
+
+	OutputLine(cmd,IsFlushLine(cmd));
+	Log("ENGINE Output: %s",cmd);
+
+	if (g_epd_mode && (!strncmp(cmd,"resign",6) || !strncmp(cmd,"1/2-1/2",7)) )	//Kein Zug
+		EpdResult("none");
+
+	if (g_epd_mode && !strncmp(cmd,"pong",4))
+		atomic_exchange32(&g_epd_pong,TRUE);
+}
+
+//------------------------------
+// IsFlushLine 
+//------------------------------
+// Zeilen, auf die die GUI wartet -> sofort ausgeben
+//
+static int IsFlushLine(const char *cmd)
+{
+	if (!strncmp(cmd,"move ",5)		||
+		!strncmp(cmd,"bestmove",8)	||
+		!strncmp(cmd,"readyok",7)	||
+		!strncmp(cmd,"uciok",5)		||
+		!strncmp(cmd,"id ",3)		||
+		!strncmp(cmd,"pong",4)		||
+		!strncmp(cmd,"feature",7)	||
+		!strncmp(cmd,"resign",6)	||
+		!strncmp(cmd,"1/2-1/2",7)	||
+		!strncmp(cmd,"1-0",3)		||
+		!strncmp(cmd,"0-1",3)		||
+		!strncmp(cmd,"Illegal",7)	||
+		!strncmp(cmd,"mmwaits",7)	||
+		!strncmp(cmd,"Error",5) )
+		return TRUE;
+
+	return FALSE;
+}
+
+//------------------------------
+// EchoDisplay 
+//------------------------------
+// Displayanzeige auf der Konsole, im Xboard Modus nur ins Logfile (stiller Kanal)
+//
+void EchoDisplay(const char *display)
+{
+	char buffer[20];
+
+	if (g_xboard_mode)
+		return;
+
+	sprintf(buffer,"%.10s\n",display);
+	OutputLine(buffer,TRUE);
+}
+//------------------------------
+// GetKeycodeGlasgow
+//------------------------------
+static EMU_KEY_T *GetKeycodeGlasgow(char inp)
+{
+	static MM_TLS EMU_KEY_T keycode;
+	switch (inp)
+	{
+
+	case	'a':
+		strcpy(keycode.name,"LINE0");
+		keycode.data=32;
+		return (&keycode);
+
+	case	'b':
+		strcpy(keycode.name,"LINE0");
+		keycode.data=128;
+		return (&keycode);
+
+	case	'c':
+		strcpy(keycode.name,"LINE0");
+		keycode.data=4;
+		return (&keycode);
+
+	case	'd':
+		strcpy(keycode.name,"LINE0");
+		keycode.data=16;
+		return (&keycode);
+
+   	case	'e':
+		strcpy(keycode.name,"LINE1");
+		keycode.data=1;
+		return (&keycode);
+
+   	case	'f':
+		strcpy(keycode.name,"LINE0");
 		keycode.data=64;
 		return (&keycode);
 
@@ -958,7 +1684,7 @@ static EMU_KEY_T *GetKeycodeGlasgow(char inp)
 //------------------------------
 static EMU_KEY_T *GetKeycodeGlasgowNew(char inp)
 {
-	static EMU_KEY_T keycode;
+	static MM_TLS EMU_KEY_T keycode;
 	switch (inp)
 	{
 
@@ -1099,7 +1825,7 @@ static EMU_KEY_T *GetKeycodeGlasgowNew(char inp)
 //------------------------------
 static EMU_KEY_T *GetKeycodeMM(char inp)
 {
-	static EMU_KEY_T keycode;
+	static MM_TLS EMU_KEY_T keycode;
 	switch (inp)
 	{
 
@@ -1308,8 +2034,45 @@ static int checkPromo(char *move)
 //------------------------------
 static void SendBestmoveToGUI(char* cmd)
 {
-	printf("move %s",cmd);
-	Log("ENGINE Output: move %s",cmd);
+	char buffer[40];
+	char first[10];
+	char second[10];
+	int len;
+
+	if (g_uci_mode)
+	{
+		len=MIN(strcspn(cmd,"\n"),5);
+
+		if (g_uci_count < UCI_MOVES_MAX)						//Zug gehoert jetzt zur Partie im Modul
+		{
+			strncpy(g_uci_moves[g_uci_count],cmd,len);
+			g_uci_moves[g_uci_count][len]='\0';
+			g_uci_count++;
+			g_uci_total=g_uci_count;
+		}
+
+		sprintf(buffer,"bestmove %.*s",len,cmd);
+
+		if (sscanf(xcmd_info.PV,"%9s %9s",first,second)==2 &&		//2. Zug der PV als ponder
+			!strncmp(first,cmd,4) && TestMove(second))
+		{
+			second[0]=tolower(second[0]);
+			second[2]=tolower(second[2]);
+			strcat(buffer," ponder ");
+			strcat(buffer,second);
+		}
+		strcat(buffer,"\n");
+	}
+	else
+		sprintf(buffer,"move %.10s",cmd);
+
+	OutputLine(buffer,TRUE);
+	Log("ENGINE Output: %s",buffer);
+
+	OvhMoveSent();
+
+	if (g_epd_mode)
+		EpdResult(cmd);
 }
 
 //------------------------------
@@ -1493,20 +2256,128 @@ static UINT64 GetTime(void)
 	return (Getms(Time));
 }
 
+//------------------------------
+// OvhLoad                                          
+//------------------------------
+static void OvhLoad(const char *module)
+{
+	FILE *fp;
+
+	sprintf(g_ovh_file,"tc_%s.txt",module);
+
+	fp=fopen(g_ovh_file,"r");
+	if (fp==NULL)
+		return;
+
+	if (fscanf(fp,"%f %f %f %u",&g_ovh_in,&g_ovh_out,&g_ovh_dev,&g_ovh_samples)!=4)
+		g_ovh_samples=0;
+	fclose(fp);
+
+	Log("TC overhead: in %.0f ms out %.0f ms dev %.0f ms (%u moves)\n",g_ovh_in,g_ovh_out,g_ovh_dev,g_ovh_samples);
+}
+
+//------------------------------
+// OvhSave                                          
+//------------------------------
+// Nur bei Programmende, nicht nach jedem Zug (mehrere Prozesse je Modul)
+//
+static void OvhSave(void)
+{
+	FILE *fp;
+
+	if (g_ovh_file[0]=='\0' || g_ovh_samples==0)
+		return;
+
+	fp=fopen(g_ovh_file,"w");
+	if (fp==NULL)
+		return;
+
+	fprintf(fp,"%.1f %.1f %.1f %u\n",g_ovh_in,g_ovh_out,g_ovh_dev,g_ovh_samples);
+	fclose(fp);
+}
+
+//------------------------------
+// OvhSearchEnd                                          
+//------------------------------
+// Ende der Suche (Zeit abgelaufen bzw. Anzeige Bestmove), nur der erste Aufruf zaehlt
+//
+static void OvhSearchEnd(void)
+{
+	if (g_ovh_pending_in>=0 && g_ovh_t_end==0)
+		g_ovh_t_end=GetTime();
+}
+
+//------------------------------
+// OvhMoveSent                                          
+//------------------------------
+// Messung abschliessen, gleitender Mittelwert
+//
+static void OvhMoveSent(void)
+{
+	float in,out,dev;
+
+	if (g_ovh_pending_in<0 || g_ovh_t_end==0)
+	{
+		g_ovh_pending_in=-1;
+		return;
+	}
+
+	in=(float) g_ovh_pending_in;
+	out=(float) (GetTime()-g_ovh_t_end);
+	g_ovh_pending_in=-1;
+	g_ovh_t_end=0;
+
+	if (g_ovh_samples==0)
+	{
+		g_ovh_in=in;
+		g_ovh_out=out;
+	}
+	else
+	{
+		dev=(in+out)-(g_ovh_in+g_ovh_out);
+		g_ovh_dev+=OVH_ALPHA*((dev<0 ? -dev : dev)-g_ovh_dev);
+		g_ovh_in +=OVH_ALPHA*(in-g_ovh_in);
+		g_ovh_out+=OVH_ALPHA*(out-g_ovh_out);
+	}
+	g_ovh_samples++;
+
+	LogDebug("TC overhead: in %.0f ms out %.0f ms -> model %.0f ms\n",in,out,g_ovh_in+g_ovh_out+2*g_ovh_dev);
+}
+
+//------------------------------
+// OvhDelay                                          
+//------------------------------
+// Zeitverbrauch pro Zug fuer TimeControl, mit Sicherheitsabstand (2 x Abweichung)
+//
+static int OvhDelay(void)
+{
+	if (g_option_tc_delay || g_ovh_samples < OVH_MIN_SAMPLES)		//Vorgabe -mmtcdelay bzw. noch zu wenig Messwerte
+		return g_tc_delay;
+
+	return (int) (g_ovh_in+g_ovh_out+2*g_ovh_dev);
+}
+
 /*----------------------------------------------------------------------------*/
 /* Zugzeit berechnen                                                          */
 /*----------------------------------------------------------------------------*/
-static void TimeControl(TC_T *p_tc)
+static void TimeControl(running_machine *machine, TC_T *p_tc)
 {
 	int InOutTime;
+	int tc_delay;
 
 	p_tc->movetime=0;
 
+	tc_delay=g_vclock ? 0 : OvhDelay();								//Zugein/ausgabe laeuft in Emulatorzeit mit
 
 //-----------------------------------------------------//
 // Statzeit Suche                                      // 
 //-----------------------------------------------------//
 	p_tc->starttime=GetTime();	
+	p_tc->vstart=timer_get_time(machine);
+
+	g_ovh_t_end=0;														//Messung Zeitverbrauch Zugein/ausgabe
+	g_ovh_pending_in=g_ovh_t_input ? (INT32) (p_tc->starttime-g_ovh_t_input) : -1;
+	g_ovh_t_input=0;
 
 //-----------------------------------------------------//
 // Feste Zeit pro Zug                                  // 
@@ -1526,11 +2397,11 @@ static void TimeControl(TC_T *p_tc)
 	if (p_tc->movestogo)
 	{
 
-		InOutTime=p_tc->movestogo * g_tc_delay;					
+		InOutTime=p_tc->movestogo * tc_delay;					
 
-		//PrintAndLog("g_tc_delay: %d, InOutTime: %d, time: %d\n",g_tc_delay,InOutTime,p_tc->time);
+		//PrintAndLog("tc_delay: %d, InOutTime: %d, time: %d\n",tc_delay,InOutTime,p_tc->time);
 
-		if ( (p_tc->time-InOutTime) > g_tc_delay)
+		if ( (p_tc->time-InOutTime) > tc_delay)
 			p_tc->time=p_tc->time - InOutTime;
 	
 		p_tc->movetime=p_tc->time/p_tc->movestogo;
@@ -1548,38 +2419,163 @@ static void TimeControl(TC_T *p_tc)
 // Sonst Zeit pro Zug berechnen
 // z.B. TIME_MOVE_DIV=40 = 2,25 % pro Zug zuzglich die Hlfte vom Zeitzuschlag, abzglich Zetverzug aus Zugein/ausgabe
 //
-	p_tc->movetime=(p_tc->time/TIME_MOVE_DIV + (p_tc->inc/2)) - g_tc_delay;
+	p_tc->movetime=(p_tc->time/TIME_MOVE_DIV + (p_tc->inc/2)) - tc_delay;
 	if ( p_tc->movetime >= p_tc->time)				 
 		 p_tc->movetime=p_tc->inc-500;
 
 	if (p_tc->movetime<0)													// Falls Zeit aus ist + 100 ms
-			p_tc->movetime=100+g_tc_delay;
+			p_tc->movetime=100+tc_delay;
+
+	if (p_tc->time && p_tc->movetime+tc_delay > (INT32) p_tc->time/2)		// Nie mehr als die halbe Restzeit
+	{
+		p_tc->movetime=p_tc->time/2-tc_delay;
+		if (p_tc->movetime<100)
+			p_tc->movetime=100;
+	}
 
-	Log("Movetime: %d, time: %d, inc: %d g_tc_delay: %d\n",p_tc->movetime,p_tc->time,p_tc->inc,g_tc_delay);
+	Log("Movetime: %d, time: %d, inc: %d tc_delay: %d\n",p_tc->movetime,p_tc->time,p_tc->inc,tc_delay);
 }
 
 //------------------------------
 // TimeOver                                          
 //------------------------------
-static int TimeOver(TC_T *p_tc)
+static int TimeOver(running_machine *machine, TC_T *p_tc)
 {
-	UINT64 endtime;
+	UINT64 used;
 
-	endtime=GetTime();
+	used=TimeUsed(machine,p_tc);
 
-	if (endtime-p_tc->starttime < 100)									//Mindesten 0,1 Sekunden suchen
+	if (used < 100)														//Mindesten 0,1 Sekunden suchen
 		return FALSE;
 
-	//Log("Check TimeOver used: %llu   Movetime: %u\n",endtime-p_tc->starttime,p_tc->movetime);
+	//Log("Check TimeOver used: %llu   Movetime: %u\n",used,p_tc->movetime);
 
-	if ( (endtime-p_tc->starttime) > p_tc->movetime)					 
+	if ( used > p_tc->movetime)					 
 	{
-		Log("Break: time used %llu > Movetime: %u\n",endtime-p_tc->starttime,p_tc->movetime);
+		Log("Break: time used %llu > Movetime: %u\n",used,p_tc->movetime);
 		return TRUE;
 	}
 	
 return FALSE;
 }
+
+//------------------------------
+// TimeUsed                                          
+//------------------------------
+// Verbrauchte Zeit in ms, bei -mmvclock Emulatorzeit umgerechnet auf den Originaltakt
+//
+static UINT64 TimeUsed(running_machine *machine, TC_T *p_tc)
+{
+	attotime used;
+
+	if (!g_vclock)
+		return GetTime()-p_tc->starttime;
+
+	used=attotime_sub(timer_get_time(machine),p_tc->vstart);
+
+	return (UINT64) (attotime_to_double(used)*1000.0) * g_clock / g_org_clock;
+}
+
+//------------------------------
+// VClockExpired                                          
+//------------------------------
+// Timer, Zugzeit in Emulatorzeit abgelaufen -> Suche genau hier abbrechen
+//
+static TIMER_CALLBACK( VClockExpired )
+{
+	if (g_state!=SEARCHING || g_break_search)
+		return;
+
+	Log(" ->Time Over (emulated %u ms)\n",(UINT32) TimeUsed(machine,&g_tc));
+
+	StopSearch(machine);
+}
+
+//------------------------------
+// CycleBudgetExpired                                          
+//------------------------------
+// Timer auf Ende der Zyklenvorgabe, bei Rest (Wartezustaende, Rundung) neu setzen
+//
+static TIMER_CALLBACK( CycleBudgetExpired )
+{
+	running_device *cpu = devtag_get_device(machine, "maincpu");
+	UINT64 total;
+
+	if (g_state!=SEARCHING || g_break_search || !g_cycle_budget)
+		return;
+
+	total=cpu_get_total_cycles(cpu);
+	if (total < g_cycle_end)
+	{
+		timer_adjust_oneshot(g_cycle_timer,cpu_clocks_to_attotime(cpu,g_cycle_end-total),0);
+		return;
+	}
+
+	Log(" ->Cycle budget used (%llu cycles over)\n",total-g_cycle_end);
+
+	StopSearch(machine);
+}
+
+//------------------------------
+// CycleBudgetStart                                          
+//------------------------------
+// TRUE wenn die Suche ueber Zyklen statt Zeit begrenzt wird
+//
+static int CycleBudgetStart(running_machine *machine, TC_T *p_tc)
+{
+	running_device *cpu = devtag_get_device(machine, "maincpu");
+	UINT64 budget;
+
+	g_cycle_budget=FALSE;
+
+	if (g_cycles_fixed)
+		budget=g_cycles_fixed;
+	else if (g_nps)
+		budget=(UINT64) g_nps * ((p_tc->movetime < 100) ? 100 : p_tc->movetime) / 1000;
+	else
+		return FALSE;
+
+	g_cycle_end=cpu_get_total_cycles(cpu)+budget;
+	g_cycle_budget=TRUE;
+
+	timer_adjust_oneshot(g_cycle_timer,cpu_clocks_to_attotime(cpu,budget),0);
+	Log("Cycle budget: %llu cycles\n",budget);
+
+	return TRUE;
+}
+
+//------------------------------
+// VClockStart                                          
+//------------------------------
+// Timer auf das Ende der Zugzeit setzen (Originaltakt -> aktueller Takt)
+//
+static void VClockStart(running_machine *machine, TC_T *p_tc)
+{
+	UINT64 ms;
+
+	ms=(p_tc->movetime < 100) ? 100 : p_tc->movetime;					//Mindesten 0,1 Sekunden suchen
+	ms=ms * g_org_clock / g_clock;
+
+	timer_adjust_oneshot(g_vclock_timer,ATTOTIME_IN_MSEC(ms),0);
+	Log("Virtual clock: stop after %u ms emulated\n",(UINT32) ms);
+}
+
+//------------------------------
+// SearchTimersReset                                          
+//------------------------------
+// Ende der Suche bzw. vor einer Suche ohne Grenze: Timer von vclock und Zyklenvorgabe entschaerfen
+// Sonst bricht ein uebrig gebliebener Timer eine spaetere analyze/go infinite/ponder Suche ab
+//
+static void SearchTimersReset(void)
+{
+	if (g_vclock_timer!=NULL)
+		timer_reset(g_vclock_timer,attotime_never);
+	if (g_cycle_timer!=NULL)
+		timer_reset(g_cycle_timer,attotime_never);
+
+	g_cycle_budget=FALSE;
+}
+
 //------------------------------
 // clearTC                                          
 //------------------------------
@@ -1601,37 +2597,3338 @@ static void clearTC(void)
 }
 
 //------------------------------
-// LogProfiler                                          
+// LogProfiler                                          
+//------------------------------
+static void LogProfiler(running_machine *machine)
+{
+	astring profilertext;
+
+	if (g_waitCnt % 10 == 0)												 	
+	{																	 
+		profiler_get_text(machine, profilertext);
+
+		if (astring_len(&profilertext) > 0)								 
+			Log("Profiler: \n\n%s\n",astring_c(&profilertext));			 
+
+		astring_free(&profilertext);										 
+	}																	 
+
+}
+//------------------------------
+// PrintLevel                                         
+//------------------------------
+static void PrintLevel()
+{
+	PrintAndLog("Supported Levels:\n\n");
+	PrintAndLog("Level 0: 3   seconds/move   -> st 3\n");
+	PrintAndLog("Level 1: 5   seconds/move   -> st 5\n");
+	PrintAndLog("Level 2: 10  seconds/move   -> st 10\n");
+	PrintAndLog("Level 3: 20  seconds/move   -> st 20\n");
+	PrintAndLog("Level 4: 60  seconds/move   -> st 60\n");
+	PrintAndLog("Level 5: 120 seconds/move   -> st 120\n");
+	PrintAndLog("Level 6: 40 move in 2 hours -> level 40 120 0\n\n");
+}
+//------------------------------
+// EPD Testlauf
+//------------------------------
+// -mmepd <datei> -mmst <sec> -mmjobs <n> -mmreport <datei>
+// Der Master verteilt die Stellungen auf n Prozesse (je ein CPU Kern), jeder Prozess
+// gibt die Stellungen ueber einen eigenen Thread statt stdin ein (new, force, st, setboard, go)
+//
+#define EPD_FEN_MAX		100
+#define EPD_OP_MAX		60
+
+typedef struct epd_pos_struct
+{
+	char fen[EPD_FEN_MAX];
+	char id[EPD_OP_MAX];
+	char bm[EPD_OP_MAX];
+	char am[EPD_OP_MAX];
+}EPD_POS_T;
+
+static EPD_POS_T *g_epd_pos=NULL;
+static int g_epd_count=0;
+static int g_epd_job=0;						//Nummer Worker
+static int g_epd_jobs=1;					//Anzahl Worker
+static int g_epd_st=10;						//Sekunden pro Stellung
+static char g_epd_report[260];
+
+static char g_epd_move[10];					//Zug der Engine
+static volatile INT32 g_epd_done=FALSE;
+
+//------------------------------
+// EpdOperand
+//------------------------------
+// Operand einer EPD Operation (z.B. bm Nf3 Qe5;) nach dest kopieren
+//
+static void EpdOperand(const char *line, const char *op, char *dest)
+{
+	const char *p;
+	int i=0;
+
+	dest[0]='\0';
+
+	p=strstr(line,op);
+	while (p!=NULL && p!=line && p[-1]!=' ' && p[-1]!=';')
+		p=strstr(p+1,op);
+	if (p==NULL)
+		return;
+
+	p+=strlen(op);
+	while (*p==' ' || *p=='"')
+		p++;
+
+	while (*p!='\0' && *p!=';' && *p!='"' && i<EPD_OP_MAX-1)
+		dest[i++]=*p++;
+	dest[i]='\0';
+}
+
+//------------------------------
+// EpdLoad
+//------------------------------
+static int EpdLoad(const char *file)
+{
+	FILE *fp;
+	char line[512];
+	char *p;
+	int fields;
+	int size=0;
+	EPD_POS_T *pos;
+
+	fp=fopen(file,"r");
+	if (fp==NULL)
+	{
+		fprintf(stderr,"EPD file %s not found\n",file);		//Master ohne Output Thread
+		return FALSE;
+	}
+
+	while (fgets(line,sizeof(line),fp)!=NULL)
+	{
+		if ((p=strpbrk(line,"\r\n"))!=NULL)
+			*p='\0';
+
+		if (line[0]=='\0' || line[0]=='#')
+			continue;
+
+		if (g_epd_count>=size)
+		{
+			size=size ? size*2 : 256;
+			g_epd_pos=(EPD_POS_T *) realloc(g_epd_pos,size*sizeof(EPD_POS_T));
+		}
+		pos=&g_epd_pos[g_epd_count];
+
+// Die ersten 4 Felder sind die Stellung, dann die Operationen
+//
+		for (p=line,fields=0; *p!='\0'; p++)
+			if (*p==' ' && p[1]!=' ' && ++fields==4)
+				break;
+
+		snprintf(pos->fen,EPD_FEN_MAX,"%.*s 0 1",(int) (p-line),line);
+
+		EpdOperand(p,"bm ",pos->bm);
+		EpdOperand(p,"am ",pos->am);
+		EpdOperand(p,"id ",pos->id);
+		if (pos->id[0]=='\0')
+			sprintf(pos->id,"%d",g_epd_count+1);
+
+		g_epd_count++;
+	}
+	fclose(fp);
+
+	if (g_epd_count==0)
+		fprintf(stderr,"EPD file %s has no positions\n",file);
+
+	return g_epd_count>0;
+}
+
+//------------------------------
+// EpdMatchSAN
+//------------------------------
+// Vereinfachter Vergleich Zug der Engine (e2e4) mit SAN (Nf3, exd5, O-O, e8=Q)
+// Die Legalitaet wird nicht geprueft, der Zug der Engine ist legal
+//
+static int EpdMatchSAN(const char *fen, const char *move, const char *san)
+{
+	char board[64];								//Index 0 = a8 wie im FEN
+	char s[12];
+	char piece;
+	int i,k,len;
+	int from,to;
+
+	if (TestMove((char *)san))					//Zug in Koordinatenschreibweise
+		return !strncmp(move,san,4);
+
+	memset(board,' ',sizeof(board));
+	for (i=0,k=0; fen[i]!='\0' && fen[i]!=' ' && k<64; i++)
+	{
+		if (isdigit((UINT8)fen[i]))
+			k+=fen[i]-'0';
+		else if (fen[i]!='/')
+			board[k++]=fen[i];
+	}
+
+	from=('8'-move[1])*8 + (move[0]-'a');
+	to  =('8'-move[3])*8 + (move[2]-'a');
+	piece=toupper(board[from]);
+
+// SAN ohne +#!?x= 
+//
+	for (i=0,len=0; san[i]!='\0' && len<11; i++)
+		if (!strchr("+#!?x=",san[i]))
+			s[len++]=san[i];
+	s[len]='\0';
+
+	if (!strncmp(s,"O-O-O",5) || !strncmp(s,"0-0-0",5))
+		return piece=='K' && move[2]=='c' && move[0]=='e';
+	if (!strncmp(s,"O-O",3) || !strncmp(s,"0-0",3))
+		return piece=='K' && move[2]=='g' && move[0]=='e';
+
+// Umwandlung am Ende (e8Q)
+//
+	if (len>2 && strchr("QRBN",s[len-1]) && islower((UINT8)s[0]))
+	{
+		if (tolower(s[len-1]) != (move[4] ? move[4] : 'q'))
+			return FALSE;
+		s[--len]='\0';
+	}
+
+	if (len<2 || s[len-2]!=move[2] || s[len-1]!=move[3])	//Zielfeld
+		return FALSE;
+
+	if (isupper((UINT8)s[0]))					//Figur mit Disambiguierung
+	{
+		if (s[0]!=piece)
+			return FALSE;
+		for (i=1; i<len-2; i++)
+			if (s[i]!=move[0] && s[i]!=move[1])
+				return FALSE;
+		return TRUE;
+	}
+
+	if (piece!='P')								//Bauer, bei Schlagzug mit Linie
+		return FALSE;
+	return len==2 || s[0]==move[0];
+}
+
+//------------------------------
+// EpdMatchList
+//------------------------------
+// TRUE wenn der Zug in der Liste (bm/am) vorkommt
+//
+static int EpdMatchList(const char *fen, const char *move, const char *list)
+{
+	char buffer[EPD_OP_MAX];
+	char *san;
+	char *tok;
+
+	strcpy(buffer,list);
+	for (san=StrTok(buffer," ",&tok); san!=NULL; san=StrTok(NULL," ",&tok))
+		if (EpdMatchSAN(fen,move,san))
+			return TRUE;
+
+	return FALSE;
+}
+
+//------------------------------
+// EpdResult
+//------------------------------
+// Zug der Engine -> Feeder Thread
+//
+static void EpdResult(const char *move)
+{
+	int i;
+
+	for (i=0; i<9 && move[i]!='\0' && move[i]!='\n'; i++)
+		g_epd_move[i]=move[i];
+	g_epd_move[i]='\0';
+
+	atomic_exchange32(&g_epd_done,TRUE);
+}
+
+//------------------------------
+// InputPush
+//------------------------------
+// Zeile wie von stdin in die Eingabe-Warteschlange stellen
+//
+static void InputPush(MODRS_IO_T *io, const char *line)
+{
+	char *slot;
+
+	WaitInputSpace(io);
+
+	slot=InputSlot(io,io->in_head);
+	strncpy(slot,line,IN_LINE_MAX-1);
+	slot[IN_LINE_MAX-1]='\0';
+
+	InputAvailable(io);
+}
+
+//------------------------------
+// EPD Feeder Thread
+//------------------------------
+// Ersetzt den Input Thread im EPD Testlauf
+//
+THREAD_PROC_RET ThreadFuncEpd(void* data)
+{
+	MODRS_IO_T *io=(MODRS_IO_T *) data;
+	FILE *fp;
+	EPD_POS_T *pos;
+	char line[200];
+	osd_ticks_t start;
+	osd_ticks_t timeout;
+	int solved;
+	int i;
+
+	fp=fopen(g_epd_report,"w");
+
+	timeout=osd_ticks_per_second()*(g_epd_st*4+60);		//Emulation haengt -> Stellung ueberspringen
+
+	InputPush(io,"xboard");
+	InputPush(io,"protover 2");
+
+	for (i=g_epd_job; i<g_epd_count; i+=g_epd_jobs)
+	{
+		pos=&g_epd_pos[i];
+
+		atomic_exchange32(&g_epd_done,FALSE);
+		strcpy(g_epd_move,"none");
+
+		InputPush(io,"new");
+		InputPush(io,"force");
+		sprintf(line,"st %d",g_epd_st);
+		InputPush(io,line);
+		sprintf(line,"setboard %s",pos->fen);
+		InputPush(io,line);
+
+		start=osd_ticks();
+		InputPush(io,"go");
+
+		while (!g_epd_done && osd_ticks()-start < timeout)
+			osd_sleep(osd_ticks_per_second()/100);
+
+// Zeit ueberschritten -> Suche abbrechen, erst nach Zug bzw. pong die naechste Stellung
+// Sonst kommt new waehrend das ROM noch rechnet
+//
+		if (!g_epd_done)
+		{
+			fprintf(stderr,"job %d: %s timeout, search stopped\n",g_epd_job,pos->id);
+
+			atomic_exchange32(&g_epd_pong,FALSE);
+			InputPush(io,"?");
+			sprintf(line,"ping %d",i+1);
+			InputPush(io,line);
+
+			start=osd_ticks();
+			while (!g_epd_done && !g_epd_pong && osd_ticks()-start < timeout)
+				osd_sleep(osd_ticks_per_second()/100);
+
+			if (!g_epd_done && !g_epd_pong)
+			{
+				fprintf(stderr,"job %d: %s no answer, run aborted\n",g_epd_job,pos->id);
+				break;
+			}
+		}
+
+		if (pos->bm[0]!='\0')
+			solved=EpdMatchList(pos->fen,g_epd_move,pos->bm);
+		else
+			solved=!EpdMatchList(pos->fen,g_epd_move,pos->am);
+
+// Report: id  bm  am  Zug  geloest  ms
+//
+		if (fp!=NULL)
+		{
+			fprintf(fp,"%s\t%s\t%s\t%s\t%d\t%u\n",pos->id,pos->bm,pos->am,g_epd_move,solved,
+				(UINT32) ((osd_ticks()-start)*1000/osd_ticks_per_second()));
+			fflush(fp);
+		}
+		fprintf(stderr,"job %d: %s %s %s\n",g_epd_job,pos->id,g_epd_move,solved ? "ok" : "--");
+	}
+
+	if (fp!=NULL)
+		fclose(fp);
+
+	InputPush(io,"quit");
+
+	return 0;
+}
+
+//------------------------------
+// EpdMaster
+//------------------------------
+// Rueckgabe TRUE  -> Master, Testlauf ist beendet (Fehlercode in error)
+//			 FALSE -> Worker (bzw. nur ein Job), weiter mit der Emulation
+//
+static int EpdMaster(core_options *options, int *error)
+{
+	FILE *fp;
+	FILE *part;
+	char file[280];
+	char line[512];
+	int total=0;
+	int solved=0;
+	int i;
+	char *p;
+
+	g_epd_st=options_get_int(options,"mmst");
+	g_epd_jobs=options_get_int(options,"mmjobs");
+	strncpy(g_epd_report,options_get_string(options,"mmreport"),sizeof(g_epd_report)-1);
+
+	if (!EpdLoad(options_get_string(options,"mmepd")))
+	{
+		*error=MAMERR_MISSING_FILES;
+		return TRUE;
+	}
+
+	if (g_epd_jobs<1)
+		g_epd_jobs=1;
+	if (g_epd_jobs>g_epd_count)
+		g_epd_jobs=g_epd_count;
+
+	g_epd_mode=TRUE;
+
+#if defined linux
+	if (g_epd_jobs>1)
+	{
+		int cpus=sysconf(_SC_NPROCESSORS_ONLN);
+		cpu_set_t mask;
+		pid_t pid;
+
+		for (i=0; i<g_epd_jobs; i++)
+		{
+			pid=fork();
+			if (pid==0)											//Worker
+			{
+				CPU_ZERO(&mask);
+				CPU_SET(i % cpus,&mask);
+				sched_setaffinity(0,sizeof(mask),&mask);
+
+				g_epd_job=i;
+				sprintf(file,"%s.%d",g_epd_report,i);
+				strcpy(g_epd_report,file);
+				sprintf(g_io->logfile,"log%d_",i);
+
+				if (freopen("/dev/null","w",stdout)==NULL)		//Engine Ausgaben nicht benoetigt
+					fprintf(stderr,"job %d: stdout not redirected\n",i);
+
+				return FALSE;
+			}
+			if (pid<0)
+			{
+				PrintAndLog("fork failed, %d jobs started\n",i);
+				g_epd_jobs=i;
+				break;
+			}
+		}
+
+		while (wait(NULL)>0)
+			;
+
+// Teilergebnisse zusammenfassen
+//
+		fp=fopen(g_epd_report,"w");
+		for (i=0; i<g_epd_jobs && fp!=NULL; i++)
+		{
+			sprintf(file,"%s.%d",g_epd_report,i);
+			part=fopen(file,"r");
+			if (part==NULL)
+				continue;
+			while (fgets(line,sizeof(line),part)!=NULL)
+			{
+				fputs(line,fp);
+				total++;
+				p=strrchr(line,'\t');						//vorletztes Feld = geloest
+				if (p!=NULL && p-line>=2 && p[-1]=='1' && p[-2]=='\t')
+					solved++;
+			}
+			fclose(part);
+			remove(file);
+		}
+		if (fp!=NULL)
+			fclose(fp);
+
+		printf("EPD: %d of %d solved (%d positions, %d jobs) -> %s\n",solved,total,g_epd_count,g_epd_jobs,g_epd_report);
+		fflush(stdout);
+
+		return TRUE;
+	}
+#endif
+
+	g_epd_jobs=1;												//Windows bzw. ein Job: im eigenen Prozess
+	return FALSE;
+}
+
+//------------------------------
+// Match Engine gegen Engine
+//------------------------------
+// <modul> -mmmatch <gegner> -mmgames <n> -mmst <sec> -mmjobs <n> -mmpgn <datei>
+// Beide Maschinen laufen im eigenen Prozess, jede in ihrem Emulationsthread mit eigener
+// Ein-/Ausgabe (AttachEngineIO ohne stdin/stdout). Der Schiedsrichter schreibt die Zuege direkt
+// in die Eingabe-Warteschlange (InputPush) und liest die Ausgabe (OutputTake).
+// Je Job ein Schiedsrichter Thread mit einem Paar Maschinen, die Partien werden vorab auf die
+// Jobs verteilt, ein Job ohne Partien holt sich welche vom Ende einer anderen Warteschlange.
+// Gewertet wird ueber die Ausgaben aus BM_Check (resign bei MAT, 1/2-1/2 bei PATT, rE50, ...)
+//
+#define MATCH_MAX_PLY		400					//danach Remis
+#define MATCH_JOBS_MAX		64
+#define MATCH_BOOT_S		120					//Max. Zeit bis das Modul bereit ist
+#define MATCH_OTHER			2					//MatchWait: Ergebnis kam von der anderen Engine
+
+typedef struct match_game_struct
+{
+	int  a_white;								//Modul A (-gamename) hat Weiss
+	int  plies;
+	char moves[MATCH_MAX_PLY][6];				//Zuege in Koordinatenschreibweise
+	char result[8];
+	char reason[40];
+}MATCH_GAME_T;
+
+typedef struct match_engine_struct
+{
+	core_options *options;
+	char logname[24];
+	MODRS_IO_T * volatile io;					//gesetzt vom Emulationsthread
+	volatile INT32 done;
+}MATCH_ENGINE_T;
+
+typedef struct match_job_struct
+{
+	int job;
+	MATCH_ENGINE_T engine[2];					//0 = Modul A, 1 = Modul B
+	Thandle thread;
+	Thandle engine_thread[2];
+}MATCH_JOB_T;
+
+static MATCH_GAME_T *g_match_games=NULL;
+static int g_match_count=0;
+static int g_match_jobs=1;
+static int g_match_st=10;
+static char g_match_name[2][20];
+static volatile INT32 g_match_queue[MATCH_JOBS_MAX];		//je Job: Kopf << 16 | Ende (Index Partie)
+static volatile INT32 g_match_running=0;
+static volatile INT32 g_match_boot=FALSE;					//Start der Maschinen nacheinander
+
+//------------------------------
+// OutputTake -> Schiedsrichter
+//------------------------------
+// Ersetzt den Output Thread, wenn die Engine ohne stdout laeuft
+//
+static int OutputTake(MODRS_IO_T *io, char *line, int size, int millisec)
+{
+	OUT_LINE_T *out;
+
+	if (!OutputQueued(io) && millisec != 0)
+	{
+		LockCondMutex(io->MutexOutput);
+		if (!OutputQueued(io))
+			WaitCondOutput(io,millisec);
+		UnLockCondMutex(io->MutexOutput);
+	}
+
+	if (!OutputQueued(io))
+		return FALSE;
+
+	out=&io->out_queue[io->out_tail & (OUT_QUEUE_SIZE-1)];
+	strncpy(line,out->line,size-1);
+	line[size-1]='\0';
+	atomic_add32(&io->out_tail,1);
+
+	return TRUE;
+}
+
+//------------------------------
+// MatchTake
+//------------------------------
+// Naechste Partie: vorne aus der eigenen Warteschlange, sonst hinten aus einer fremden
+// Rueckgabe -1 = keine Partie mehr
+//
+static int MatchTake(int job)
+{
+	INT32 old;
+	int head,tail;
+	int i,v;
+
+	for (i=0; i<g_match_jobs; i++)
+	{
+		v=(job+i) % g_match_jobs;
+		for (;;)
+		{
+			old=g_match_queue[v];
+			head=old >> 16;
+			tail=old & 0xffff;
+			if (head>=tail)
+				break;
+
+			if (v==job)
+			{
+				if (compare_exchange32(&g_match_queue[v],old,((head+1) << 16) | tail)==old)
+					return head;
+			}
+			else if (compare_exchange32(&g_match_queue[v],old,(head << 16) | (tail-1))==old)
+				return tail-1;
+		}
+	}
+
+	return -1;
+}
+
+//------------------------------
+// Emulationsthread einer Match Engine
+//------------------------------
+THREAD_PROC_RET ThreadFuncMatchEngine(void* data)
+{
+	MATCH_ENGINE_T *e=(MATCH_ENGINE_T *) data;
+
+	AttachEngineIO(NULL,NULL,e->logname);
+	e->io=g_io;
+
+	mame_execute(e->options);
+
+	atomic_exchange32(&e->done,TRUE);
+	return 0;
+}
+
+//------------------------------
+// MatchResultLine
+//------------------------------
+static int MatchResultLine(const char *line)
+{
+	return !strncmp(line,"resign",6) || !strncmp(line,"1/2-1/2",7) ||
+		   !strncmp(line,"1-0",3) || !strncmp(line,"0-1",3);
+}
+
+//------------------------------
+// MatchWait
+//------------------------------
+// Ausgabe der Engine lesen bis eine Zeile mit prefix kommt, die andere Engine wird mit geleert
+// Ohne prefix (Partie) zaehlen resign bzw. Ergebnis der anderen Engine, z.B. MAT nach dem eigenen Zug
+// Rueckgabe FALSE bei Timeout oder Ende der Engine, MATCH_OTHER wenn line von der anderen Engine kommt
+//
+static int MatchWait(MATCH_JOB_T *job, int e, const char *prefix, char *line, int size, int seconds)
+{
+	osd_ticks_t end=osd_ticks()+osd_ticks_per_second()*seconds;
+	char other[OUT_LINE_MAX];
+
+	while (osd_ticks()<end && !job->engine[e].done)
+	{
+		while (job->engine[e^1].io!=NULL && OutputTake(job->engine[e^1].io,other,sizeof(other),0))
+		{
+			if (prefix==NULL && MatchResultLine(other))
+			{
+				strncpy(line,other,size-1);
+				line[size-1]='\0';
+				return MATCH_OTHER;
+			}
+		}
+
+		if (!OutputTake(job->engine[e].io,line,size,10))
+			continue;
+
+		if (prefix==NULL || !strncmp(line,prefix,strlen(prefix)))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+//------------------------------
+// MatchOptions
+//------------------------------
+// Optionen je Maschine eines Jobs: ohne Fenster, Sound und Artwork
+// Render Targets, UI und Ausgabesystem gibt es nur einmal im Prozess (siehe video.c)
+//
+static void MatchOptions(core_options *opts)
+{
+	options_set_string(opts,"video","none",OPTION_PRIORITY_CMDLINE);
+	options_set_bool(opts,"sound",FALSE,OPTION_PRIORITY_CMDLINE);
+	options_set_bool(opts,"use_backdrops",FALSE,OPTION_PRIORITY_CMDLINE);
+	options_set_bool(opts,"use_overlays",FALSE,OPTION_PRIORITY_CMDLINE);
+	options_set_bool(opts,"use_bezels",FALSE,OPTION_PRIORITY_CMDLINE);
+	options_set_bool(opts,"skip_gameinfo",TRUE,OPTION_PRIORITY_CMDLINE);
+}
+
+//------------------------------
+// MatchBoot
+//------------------------------
+// Maschinen eines Jobs nacheinander starten (Validierung, ROMs, OSD sind nicht reentrant)
+//
+static int MatchBoot(MATCH_JOB_T *job, int engines)
+{
+	char line[OUT_LINE_MAX];
+	int dwThreadID;
+	int e;
+	int ok=TRUE;
+
+	for (e=0; e<engines && ok; e++)
+	{
+		while (compare_exchange32(&g_match_boot,FALSE,TRUE)!=FALSE)
+			osd_sleep(osd_ticks_per_second()/100);
+
+		BeginThread(job->engine_thread[e],ThreadFuncMatchEngine,&job->engine[e],dwThreadID)
+
+		while (job->engine[e].io==NULL)
+			osd_sleep(osd_ticks_per_second()/1000);
+
+		InputPush(job->engine[e].io,"xboard");
+		InputPush(job->engine[e].io,"protover 2");
+		ok=MatchWait(job,e,"feature",line,sizeof(line),MATCH_BOOT_S);
+
+		atomic_exchange32(&g_match_boot,FALSE);
+
+		if (!ok)
+			fprintf(stderr,"match job %d: %s not ready\n",job->job,g_match_name[e]);
+	}
+
+	return ok;
+}
+
+//------------------------------
+// MatchSync
+//------------------------------
+// Laufende Suche abbrechen, Zuege und Ergebnisse der alten Partie verwerfen (ping/pong)
+//
+static void MatchSync(MATCH_JOB_T *job, int id)
+{
+	char line[OUT_LINE_MAX];
+	char ping[20];
+	int e;
+
+	sprintf(ping,"ping %d",id);
+
+	for (e=0; e<2; e++)
+	{
+		if (job->engine[e].done)
+			continue;
+		InputPush(job->engine[e].io,"?");
+		InputPush(job->engine[e].io,"new");
+		InputPush(job->engine[e].io,ping);
+	}
+
+	sprintf(ping,"pong %d",id);
+
+	for (e=0; e<2; e++)
+		if (!job->engine[e].done)
+			MatchWait(job,e,ping,line,sizeof(line),g_match_st*4+60);
+}
+
+//------------------------------
+// MatchPlay
+//------------------------------
+static void MatchPlay(MATCH_JOB_T *job, int g)
+{
+	MATCH_GAME_T *game=&g_match_games[g];
+	char line[OUT_LINE_MAX];
+	char *p;
+	int side;									//Engine am Zug (0 = A, 1 = B)
+	int from;									//Engine der gelesenen Zeile
+	int ret;
+	int e;
+
+	MatchSync(job,g+1);
+
+	sprintf(line,"st %d",g_match_st);
+	for (e=0; e<2; e++)
+		InputPush(job->engine[e].io,line);
+
+	side=game->a_white ? 0 : 1;
+	InputPush(job->engine[side].io,"go");
+
+	for (;;)
+	{
+		ret=MatchWait(job,side,NULL,line,sizeof(line),g_match_st*4+60);
+		if (!ret)
+		{
+			strcpy(game->result,"*");
+			sprintf(game->reason,"%s no move",g_match_name[side]);
+			break;
+		}
+		from=(ret==MATCH_OTHER) ? side^1 : side;
+
+		if (!strncmp(line,"move ",5))
+		{
+			for (p=line+5; *p==' '; p++)
+				;
+			strncpy(game->moves[game->plies],p,5);
+			game->moves[game->plies][5]='\0';
+			if ((p=strpbrk(game->moves[game->plies],"\n\r "))!=NULL)
+				*p='\0';
+
+			InputPush(job->engine[side^1].io,game->moves[game->plies]);
+
+			if (++game->plies>=MATCH_MAX_PLY)
+			{
+				strcpy(game->result,"1/2-1/2");
+				strcpy(game->reason,"ply limit");
+				break;
+			}
+			side^=1;
+		}
+		else if (!strncmp(line,"resign",6))
+		{
+			strcpy(game->result,(from==0)==(game->a_white!=0) ? "0-1" : "1-0");
+			sprintf(game->reason,"%s resigns",g_match_name[from]);
+			break;
+		}
+		else if (!strncmp(line,"1/2-1/2",7) || !strncmp(line,"1-0",3) || !strncmp(line,"0-1",3))
+		{
+			strncpy(game->result,line,7);
+			game->result[line[1]=='/' ? 7 : 3]='\0';
+			if ((p=strchr(line,'{'))!=NULL)
+			{
+				strncpy(game->reason,p+1,sizeof(game->reason)-1);
+				if ((p=strchr(game->reason,'}'))!=NULL)
+					*p='\0';
+			}
+			break;
+		}
+		else if (!strncmp(line,"Illegal",7))				//Zug der anderen Engine abgelehnt
+		{
+			strcpy(game->result,"*");
+			sprintf(game->reason,"%s: illegal move",g_match_name[side^1]);
+			break;
+		}
+	}
+
+	fprintf(stderr,"game %d: %s - %s %s (%d plies%s%s)\n",g+1,
+		g_match_name[game->a_white ? 0 : 1],g_match_name[game->a_white ? 1 : 0],
+		game->result,game->plies,game->reason[0] ? ", " : "",game->reason);
+}
+
+//------------------------------
+// Schiedsrichter Thread (ein Job)
+//------------------------------
+THREAD_PROC_RET ThreadFuncMatch(void* data)
+{
+	MATCH_JOB_T *job=(MATCH_JOB_T *) data;
+	char line[OUT_LINE_MAX];
+	osd_ticks_t end;
+	int g;
+	int e;
+
+	if (MatchBoot(job,2))
+	{
+		while ((g=MatchTake(job->job))>=0)
+		{
+			MatchPlay(job,g);
+			if (job->engine[0].done || job->engine[1].done)
+				break;
+		}
+	}
+
+	for (e=0; e<2; e++)
+		if (job->engine[e].io!=NULL && !job->engine[e].done)
+			InputPush(job->engine[e].io,"quit");
+
+	end=osd_ticks()+osd_ticks_per_second()*60;				//Ausgabe leeren bis die Maschinen beendet sind
+	for (e=0; e<2; e++)
+		while (job->engine[e].io!=NULL && !job->engine[e].done && osd_ticks()<end)
+			OutputTake(job->engine[e].io,line,sizeof(line),10);
+
+	atomic_add32(&g_match_running,-1);
+	return 0;
+}
+
+//------------------------------
+// MatchSAN
+//------------------------------
+// Zug in Koordinatenschreibweise -> SAN und auf dem Brett ausfuehren
+// Index 0 = a8 wie im FEN, ohne Schach (+), Mehrdeutigkeit ohne Fesselung
+//
+static void MatchSAN(char *board, const char *move, char *san)
+{
+	static const int knight[8][2]={{1,2},{2,1},{2,-1},{1,-2},{-1,-2},{-2,-1},{-2,1},{-1,2}};
+	static const int ray[8][2]={{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+	char piece;
+	int from,to;
+	int f,r,k,d,n;
+	int same_file=FALSE,same_rank=FALSE,other=FALSE;
+	char *s=san;
+
+	from=('8'-move[1])*8 + (move[0]-'a');
+	to  =('8'-move[3])*8 + (move[2]-'a');
+	piece=toupper(board[from]);
+
+	if (piece=='K' && abs(move[2]-move[0])==2)			//Rochade, Turm mitziehen
+	{
+		strcpy(san,move[2]=='g' ? "O-O" : "O-O-O");
+		board[move[2]=='g' ? to-1 : to+1]=board[move[2]=='g' ? to+1 : to-2];
+		board[move[2]=='g' ? to+1 : to-2]=' ';
+		board[to]=board[from];
+		board[from]=' ';
+		return;
+	}
+
+	if (piece=='P')
+	{
+		if (move[0]!=move[2])
+		{
+			*s++=move[0];
+			*s++='x';
+			if (board[to]==' ')								//en passant
+				board[(from/8)*8 + to%8]=' ';
+		}
+		*s++=move[2];
+		*s++=move[3];
+		if (move[3]=='8' || move[3]=='1')
+		{
+			*s++='=';
+			*s++=move[4] ? toupper(move[4]) : 'Q';
+			board[from]=isupper((UINT8)board[from]) ? (move[4] ? toupper(move[4]) : 'Q') : (move[4] ? move[4] : 'q');
+		}
+		*s='\0';
+		board[to]=board[from];
+		board[from]=' ';
+		return;
+	}
+
+// Andere Figuren gleicher Art und Farbe, die das Zielfeld erreichen
+//
+	for (k=0; k<64; k++)
+	{
+		if (k==from || board[k]!=board[from])
+			continue;
+
+		n=FALSE;
+		if (piece=='N')
+		{
+			for (d=0; d<8 && !n; d++)
+				n=(k%8+knight[d][0]==to%8 && k/8+knight[d][1]==to/8);
+		}
+		else if (piece!='K')
+		{
+			for (d=(piece=='B' ? 4 : 0); d<(piece=='R' ? 4 : 8) && !n; d++)
+			{
+				for (f=k%8+ray[d][0],r=k/8+ray[d][1]; f>=0 && f<8 && r>=0 && r<8; f+=ray[d][0],r+=ray[d][1])
+				{
+					if (r*8+f==to)
+					{
+						n=TRUE;
+						break;
+					}
+					if (board[r*8+f]!=' ')
+						break;
+				}
+			}
+		}
+
+		if (n)
+		{
+			other=TRUE;
+			same_file|=(k%8==from%8);
+			same_rank|=(k/8==from/8);
+		}
+	}
+
+	*s++=piece;
+	if (other && (!same_file || same_rank))
+		*s++=move[0];
+	if (other && same_file)
+		*s++=move[1];
+	if (board[to]!=' ')
+		*s++='x';
+	*s++=move[2];
+	*s++=move[3];
+	*s='\0';
+
+	board[to]=board[from];
+	board[from]=' ';
+}
+
+//------------------------------
+// MatchWritePgn
+//------------------------------
+static void MatchWritePgn(const char *file)
+{
+	static const char start[]="rnbqkbnrpppppppp                                PPPPPPPPRNBQKBNR";
+	MATCH_GAME_T *game;
+	FILE *fp;
+	char board[64];
+	char san[12];
+	char date[20];
+	time_t t;
+	int len;
+	int g,i;
+
+	fp=fopen(file,"w");
+	if (fp==NULL)
+	{
+		fprintf(stderr,"match: %s not written\n",file);
+		return;
+	}
+
+	time(&t);
+	strftime(date,sizeof(date),"%Y.%m.%d",localtime(&t));
+
+	for (g=0; g<g_match_count; g++)
+	{
+		game=&g_match_games[g];
+
+		fprintf(fp,"[Event \"Mephisto match\"]\n[Site \"MESS\"]\n[Date \"%s\"]\n[Round \"%d\"]\n",date,g+1);
+		fprintf(fp,"[White \"%s\"]\n[Black \"%s\"]\n",g_match_name[game->a_white ? 0 : 1],g_match_name[game->a_white ? 1 : 0]);
+		fprintf(fp,"[Result \"%s\"]\n[PlyCount \"%d\"]\n[TimeControl \"1/%d\"]\n\n",game->result,game->plies,g_match_st);
+
+		memcpy(board,start,sizeof(board));
+		for (i=0,len=0; i<game->plies; i++)
+		{
+			MatchSAN(board,game->moves[i],san);
+			if (len>70)
+			{
+				fputc('\n',fp);
+				len=0;
+			}
+			if (i%2==0)
+				len+=fprintf(fp,"%d. ",i/2+1);
+			len+=fprintf(fp,"%s ",san);
+		}
+
+		if (game->reason[0]!='\0')
+			fprintf(fp,"{%s} ",game->reason);
+		fprintf(fp,"%s\n\n",game->result);
+	}
+
+	fclose(fp);
+}
+
+//------------------------------
+// MatchMaster
+//------------------------------
+// Startet die Jobs, wartet auf alle Partien und schreibt das PGN
+//
+static int MatchMaster(core_options *options)
+{
+	MATCH_JOB_T *jobs;
+	int points[3]={0,0,0};						//Siege A, Remis, Siege B
+	int dwThreadID;
+	int per_job;
+	int i,e;
+
+	strncpy(g_match_name[0],options_get_string(options,OPTION_GAMENAME),sizeof(g_match_name[0])-1);
+	strncpy(g_match_name[1],options_get_string(options,"mmmatch"),sizeof(g_match_name[1])-1);
+	g_match_count=MIN(options_get_int(options,"mmgames"),0xffff);
+	g_match_jobs=options_get_int(options,"mmjobs");
+	g_match_st=options_get_int(options,"mmst");
+
+	if (g_match_count<1)
+		return MAMERR_NONE;
+	if (g_match_jobs<1)
+		g_match_jobs=1;
+	if (g_match_jobs>MIN(g_match_count,MATCH_JOBS_MAX))
+		g_match_jobs=MIN(g_match_count,MATCH_JOBS_MAX);
+
+	g_match_games=(MATCH_GAME_T *) calloc(g_match_count,sizeof(MATCH_GAME_T));
+	jobs=(MATCH_JOB_T *) calloc(g_match_jobs,sizeof(MATCH_JOB_T));
+	if (g_match_games==NULL || jobs==NULL)
+		return MAMERR_FATALERROR;
+
+	for (i=0; i<g_match_count; i++)
+	{
+		g_match_games[i].a_white=(i%2==0);				//Farbwechsel
+		strcpy(g_match_games[i].result,"*");
+	}
+
+// Partien vorab verteilen, Rest geht an die ersten Jobs
+//
+	per_job=g_match_count/g_match_jobs;
+	for (i=0,e=0; i<g_match_jobs; i++)
+	{
+		int n=per_job + (i < g_match_count % g_match_jobs);
+		g_match_queue[i]=(e << 16) | (e+n);
+		e+=n;
+	}
+
+// Je Maschine eine Kopie der Optionen (die Emulation aendert sie), ohne -mmmatch, ohne Video
+//
+	for (i=0; i<g_match_jobs; i++)
+	{
+		jobs[i].job=i;
+		for (e=0; e<2; e++)
+		{
+			jobs[i].engine[e].options=options_duplicate(options);
+			options_set_string(jobs[i].engine[e].options,OPTION_GAMENAME,g_match_name[e],OPTION_PRIORITY_CMDLINE);
+			options_set_string(jobs[i].engine[e].options,"mmmatch","",OPTION_PRIORITY_CMDLINE);
+			MatchOptions(jobs[i].engine[e].options);
+			sprintf(jobs[i].engine[e].logname,"log_m%d%c_",i,'a'+e);
+		}
+	}
+
+	g_match_running=g_match_jobs;
+	for (i=0; i<g_match_jobs; i++)
+		BeginThread(jobs[i].thread,ThreadFuncMatch,&jobs[i],dwThreadID)
+
+	while (g_match_running>0)
+		osd_sleep(osd_ticks_per_second()/10);
+
+	MatchWritePgn(options_get_string(options,"mmpgn"));
+
+	for (i=0; i<g_match_count; i++)
+	{
+		if (!strcmp(g_match_games[i].result,"1/2-1/2"))
+			points[1]++;
+		else if (!strcmp(g_match_games[i].result,"1-0"))
+			points[g_match_games[i].a_white ? 0 : 2]++;
+		else if (!strcmp(g_match_games[i].result,"0-1"))
+			points[g_match_games[i].a_white ? 2 : 0]++;
+	}
+
+	printf("Match %s - %s: +%d =%d -%d (%d games, %d jobs) -> %s\n",g_match_name[0],g_match_name[1],
+		points[0],points[1],points[2],g_match_count,g_match_jobs,options_get_string(options,"mmpgn"));
+	fflush(stdout);
+
+	free(g_match_games);							//Optionen und Kontexte bleiben, falls eine Maschine haengt
+
+	return MAMERR_NONE;
+}
+
+//------------------------------
+// Tuning Handshake Wartezeiten
+//------------------------------
+// <modul> -mmtune [-mmunlimited 0|1]
+// Eine Maschine wird wie beim Match im eigenen Thread gestartet und mit einem festen Skript
+// (Zuege, undo, remove, Umwandlung durch GUI und Modul, setboard) getestet. Je Wartezeit wird per
+// Intervallhalbierung der kleinste Wert gesucht, bei dem alle Displaybestaetigungen (MEM0, Pr _, Err,
+// Bestmove) kommen und das Modul dieselben Zuege wie mit den Vorgaben aus der Modultabelle spielt.
+// Ergebnis mit Zuschlag -> hs_<modul>.txt (je Modus und Takt), wird beim naechsten Start geladen.
+//
+#define TUNE_MOVES			8
+#define TUNE_MOVE_S			60					//Max. Zeit pro Zug bzw. Antwort
+#define TUNE_CYCLES			3000000				//Feste Arbeit pro Zug bei mmunlimited (reproduzierbar)
+#define TUNE_CONFIRM		3					//Pruefungen des Ergebnisses
+#define TUNE_MARGIN			25					//Zuschlag in %
+
+#define TUNE_OK				0
+#define TUNE_FAIL			1
+#define TUNE_HANG			2
+
+static const char *g_tune_script[] =
+{
+	"force","e2e4","d7d5","e4d5","c7c6","d5c6","g8f6","c6b7","b8d7",
+	"undo","b8d7","b7a8q","go","*",				//Umwandlung GUI, Bestmove Modul
+	"remove","b7a8n","*",						//Zuruecknehmen, Unterverwandlung
+	"new","force","setboard 8/8/8/8/8/4k3/p7/4K3 b - - 0 1","go","*",	//Umwandlung Modul
+	NULL
+};
+
+static const char *g_tune_names[5]	= { "bestmove","special","input","promo","timeout" };
+static const int   g_tune_order[5]	= { 2,4,3,1,0 };		//Eingabe zuerst, Bestmove zuletzt
+
+static char g_tune_limit[30];							//Suchvorgabe nach new
+static char g_tune_ref[TUNE_MOVES][6];					//Zuege mit den Vorgaben
+static int  g_tune_exact=TRUE;							//Zuege muessen uebereinstimmen
+static int  g_tune_id=0;
+
+//------------------------------
+// TuneProbe
+//------------------------------
+// Skript einmal mit den Wartezeiten w ausfuehren, Antworten des Moduls in moves
+//
+static int TuneProbe(MATCH_JOB_T *job, const int *w, char moves[TUNE_MOVES][6])
+{
+	MODRS_IO_T *io=job->engine[0].io;
+	char line[OUT_LINE_MAX];
+	char *p;
+	int fail=0;
+	int n=0;
+	int i;
+
+	memset(moves,0,TUNE_MOVES*6);
+
+	MatchSync(job,++g_tune_id);
+	if (job->engine[0].done)
+		return TUNE_HANG;
+
+	sprintf(line,"mmwaits %d %d %d %d %d",w[0],w[1],w[2],w[3],w[4]);
+	InputPush(io,line);
+	InputPush(io,g_tune_limit);
+	InputPush(io,"mmwaits");									//Zaehler zuruecksetzen
+	if (!MatchWait(job,0,"mmwaits",line,sizeof(line),TUNE_MOVE_S))
+		return TUNE_HANG;
+
+	for (i=0; g_tune_script[i]!=NULL; i++)
+	{
+		if (strcmp(g_tune_script[i],"*"))
+		{
+			InputPush(io,g_tune_script[i]);
+			if (!strcmp(g_tune_script[i],"new"))
+				InputPush(io,g_tune_limit);
+			continue;
+		}
+
+		for (;;)												//Antwort des Moduls
+		{
+			if (!MatchWait(job,0,NULL,line,sizeof(line),TUNE_MOVE_S))
+				return TUNE_HANG;
+
+			if (!strncmp(line,"move ",5))
+			{
+				for (p=line+5; *p==' '; p++)
+					;
+				strncpy(moves[n],p,5);
+				if ((p=strpbrk(moves[n],"\n\r "))!=NULL)
+					*p='\0';
+				break;
+			}
+			if (!strncmp(line,"resign",6)	|| !strncmp(line,"1/2-1/2",7) ||
+				!strncmp(line,"Illegal",7)	|| !strncmp(line,"Error",5) )
+			{
+				strcpy(moves[n],"-");
+				fail++;
+				break;
+			}
+		}
+		if (n<TUNE_MOVES-1)
+			n++;
+	}
+
+	InputPush(io,"mmwaits");
+	if (!MatchWait(job,0,"mmwaits",line,sizeof(line),TUNE_MOVE_S))
+		return TUNE_HANG;
+	fail+=atoi(line+8);
+
+	return fail ? TUNE_FAIL : TUNE_OK;
+}
+
+//------------------------------
+// TuneRestart
+//------------------------------
+// Maschine haengt (Tasten verloren) -> beenden und neu starten
+//
+static int TuneRestart(MATCH_JOB_T *job)
+{
+	char line[OUT_LINE_MAX];
+	osd_ticks_t end=osd_ticks()+osd_ticks_per_second()*60;
+
+	if (!job->engine[0].done)
+	{
+		InputPush(job->engine[0].io,"?");
+		InputPush(job->engine[0].io,"quit");
+		while (!job->engine[0].done && osd_ticks()<end)
+			OutputTake(job->engine[0].io,line,sizeof(line),10);
+	}
+	if (!job->engine[0].done)
+		return FALSE;
+
+	job->engine[0].io=NULL;										//Kontext der alten Maschine bleibt
+	job->engine[0].done=FALSE;
+
+	return MatchBoot(job,1);
+}
+
+//------------------------------
+// TuneCheck
+//------------------------------
+// Rueckgabe 1 = Wartezeiten sicher, 0 = nicht, -1 = Maschine laesst sich nicht neu starten
+//
+static int TuneCheck(MATCH_JOB_T *job, const int *w)
+{
+	char moves[TUNE_MOVES][6];
+	int ret;
+	int i;
+
+	ret=TuneProbe(job,w,moves);
+	if (ret==TUNE_HANG)
+	{
+		fprintf(stderr,"tune %d %d %d %d %d: no response, restart\n",w[0],w[1],w[2],w[3],w[4]);
+		return TuneRestart(job) ? 0 : -1;
+	}
+	if (ret==TUNE_FAIL)
+		return 0;
+
+	for (i=0; i<TUNE_MOVES; i++)
+	{
+		if (g_tune_exact ? strcmp(moves[i],g_tune_ref[i]) != 0
+						 : strlen(moves[i]) != strlen(g_tune_ref[i]))	//nur Zug bzw. Umwandlung vorhanden
+			return 0;
+	}
+
+	return 1;
+}
+
+//------------------------------
+// TuneRun
+//------------------------------
+static int TuneRun(MATCH_JOB_T *job, int *def, int *best)
+{
+	char moves[TUNE_MOVES][6];
+	char line[OUT_LINE_MAX];
+	int w[5];
+	int lo,hi,mid;
+	int ret;
+	int i,k,round;
+
+// Vorgaben der Modultabelle (ein vorhandenes Profil ist bereits geladen)
+//
+	InputPush(job->engine[0].io,"mmwaits default");
+	InputPush(job->engine[0].io,"mmwaits");
+	if (!MatchWait(job,0,"mmwaits",line,sizeof(line),TUNE_MOVE_S) ||
+		sscanf(line+8,"%*d %d %d %d %d %d",&def[0],&def[1],&def[2],&def[3],&def[4])!=5)
+		return FALSE;
+
+// Referenz, zweimal mit den Vorgaben
+//
+	if (TuneProbe(job,def,g_tune_ref)!=TUNE_OK || TuneProbe(job,def,moves)!=TUNE_OK)
+	{
+		fprintf(stderr,"tune %s: script fails with the default waits\n",g_match_name[0]);
+		return FALSE;
+	}
+	for (i=0; i<TUNE_MOVES; i++)
+		if (strcmp(moves[i],g_tune_ref[i]))
+		{
+			fprintf(stderr,"tune %s: moves not reproducible, checking display confirmations only\n",g_match_name[0]);
+			g_tune_exact=FALSE;
+			break;
+		}
+
+// Je Wartezeit Intervallhalbierung, die anderen bleiben auf dem bisher besten Wert
+//
+	memcpy(best,def,sizeof(w));
+	for (i=0; i<5; i++)
+	{
+		k=g_tune_order[i];
+		lo=0;
+		hi=def[k];
+		while (hi-lo > MAX(1,hi/10))
+		{
+			mid=(lo+hi)/2;
+			memcpy(w,best,sizeof(w));
+			w[k]=mid;
+			if ((ret=TuneCheck(job,w))<0)
+				return FALSE;
+			if (ret)
+				hi=mid;
+			else
+				lo=mid;
+			fprintf(stderr,"tune %s %-8s %4d %s\n",g_match_name[0],g_tune_names[k],mid,ret ? "ok" : "fail");
+		}
+		best[k]=hi;
+	}
+
+// Zuschlag, dann mehrfach pruefen, sonst Richtung Vorgabe
+//
+	for (k=0; k<5; k++)
+		best[k]=MIN(def[k],best[k]+best[k]*TUNE_MARGIN/100+1);
+
+	for (round=0; round<3; round++)
+	{
+		for (i=0; i<TUNE_CONFIRM; i++)
+			if ((ret=TuneCheck(job,best))<=0)
+				break;
+		if (ret<0)
+			return FALSE;
+		if (i==TUNE_CONFIRM)
+			return TRUE;
+
+		for (k=0; k<5; k++)
+			best[k]=(best[k]+def[k]+1)/2;
+	}
+
+	memcpy(best,def,sizeof(w));
+	return TRUE;
+}
+
+//------------------------------
+// TuneMaster
+//------------------------------
+static int TuneMaster(core_options *options)
+{
+	MATCH_JOB_T *job;
+	char line[OUT_LINE_MAX];
+	int def[5],best[5];
+	osd_ticks_t end;
+	int ok;
+	int k;
+
+	strncpy(g_match_name[0],options_get_string(options,OPTION_GAMENAME),sizeof(g_match_name[0])-1);
+
+	if (options_get_bool(options,"mmunlimited"))
+		sprintf(g_tune_limit,"cycles %d",TUNE_CYCLES);
+	else
+		strcpy(g_tune_limit,"st 3");						//Kleinste Stufe, Zuege nicht reproduzierbar
+
+	job=(MATCH_JOB_T *) calloc(1,sizeof(MATCH_JOB_T));
+	if (job==NULL)
+		return MAMERR_FATALERROR;
+
+	job->engine[0].options=options_duplicate(options);
+	options_set_bool(job->engine[0].options,"mmtune",FALSE,OPTION_PRIORITY_CMDLINE);
+	MatchOptions(job->engine[0].options);
+	strcpy(job->engine[0].logname,"log_t_");
+	job->engine[1].done=TRUE;								//nur eine Maschine
+
+	ok=MatchBoot(job,1) && TuneRun(job,def,best);
+
+	if (ok)
+	{
+		sprintf(line,"mmwaits %d %d %d %d %d",best[0],best[1],best[2],best[3],best[4]);
+		InputPush(job->engine[0].io,line);
+		InputPush(job->engine[0].io,"mmwaits save");
+		InputPush(job->engine[0].io,"mmwaits");
+		ok=MatchWait(job,0,"mmwaits",line,sizeof(line),TUNE_MOVE_S);
+
+		printf("Handshake %s (%s):",g_match_name[0],options_get_bool(options,"mmunlimited") ? "unlimited" : "real time");
+		for (k=0; k<5; k++)
+			printf(" %s %d->%d",g_tune_names[k],def[k],best[k]);
+		printf("\n");
+		fflush(stdout);
+	}
+
+	if (job->engine[0].io!=NULL && !job->engine[0].done)
+		InputPush(job->engine[0].io,"quit");
+
+	end=osd_ticks()+osd_ticks_per_second()*60;
+	while (job->engine[0].io!=NULL && !job->engine[0].done && osd_ticks()<end)
+		OutputTake(job->engine[0].io,line,sizeof(line),10);
+
+	return ok ? MAMERR_NONE : MAMERR_FATALERROR;
+}
+
+//------------------------------
+// Fork Server
+//------------------------------
+// -mmforkserver <socket>: das Modul wird einmal bis DRIVER_READY gestartet (ROMs, Messung
+// der Geschwindigkeit), danach wird fuer jede Verbindung ein Kindprozess erzeugt (copy-on-write).
+// Das Kind uebernimmt die Verbindung als stdin/stdout und startet erst dann die Threads.
+// -mmforkconnect <socket>: schlanker Client, leitet stdin/stdout an den Server weiter
+//
+static char g_fork_path[108]="";			//Pfad Socket, leer = kein Fork Server
+
+//------------------------------
+// StartThreads
+//------------------------------
+// Input, Output und Log Thread je Engine, sie bekommen den Kontext g_io
+// Ohne in/out (Match) uebernimmt der Schiedsrichter Ein- und Ausgabe
+//
+static void StartThreads(void)
+{
+	int  dwThreadID;			// IDs der Threads
+	int  dwOutThreadID;
+	int  dwLogThreadID;
+
+	if (g_io->threads_started)
+		return;
+	g_io->threads_started=TRUE;
+
+	if (g_epd_mode)
+		BeginThread(g_io->in_thread,ThreadFuncEpd,g_io,dwThreadID)
+	else if (g_io->in!=NULL)
+		BeginThread(g_io->in_thread,ThreadFuncCheckInput,g_io,dwThreadID)
+	if (g_io->out!=NULL)
+		BeginThread(g_io->out_thread,ThreadFuncOutput,g_io,dwOutThreadID)
+
+	g_io->log_start=osd_ticks();
+	BeginThread(g_io->log_thread,ThreadFuncLog,g_io,dwLogThreadID)
+}
+
+//------------------------------
+// ForkServer
+//------------------------------
+// Kehrt nur im Kindprozess zurueck
+//
+static void ForkServer(running_machine *machine)
+{
+#if defined linux
+	struct sockaddr_un addr;
+	int server;
+	int conn;
+	pid_t pid;
+
+	server=socket(AF_UNIX,SOCK_STREAM,0);
+	if (server<0)
+	{
+		Log("Fork server: no socket, continue as single engine");
+		g_fork_path[0]='\0';
+		return;
+	}
+
+	memset(&addr,0,sizeof(addr));
+	addr.sun_family=AF_UNIX;
+	strncpy(addr.sun_path,g_fork_path,sizeof(addr.sun_path)-1);
+	unlink(g_fork_path);
+
+	if (bind(server,(struct sockaddr *) &addr,sizeof(addr))<0 || listen(server,16)<0)
+	{
+		Log("Fork server: bind %s failed, continue as single engine",g_fork_path);
+		close(server);
+		g_fork_path[0]='\0';
+		return;
+	}
+
+	signal(SIGCHLD,SIG_IGN);					//Keine Zombies
+	fflush(stdout);
+
+// Der Server startet keine Threads: Ausgaben beim Booten verwerfen, Log direkt schreiben
+// Sonst erbt jedes Kind die Ringe und schickt die alten Zeilen an seinen Client
+//
+	if (g_io->out_head != g_io->out_tail)
+		Log("Fork server: %d boot output lines dropped\n",(int) (g_io->out_head-g_io->out_tail));
+	g_io->out_tail=g_io->out_head;
+	LogDrainDirect(g_io);
+
+	fprintf(stderr,"%s ready, fork server on %s\n",machine->gamedrv->name,g_fork_path);
+
+	for (;;)
+	{
+		conn=accept(server,NULL,NULL);
+		if (conn<0)
+			continue;
+
+		pid=fork();
+		if (pid==0)								//Kind: Verbindung ist stdin/stdout
+		{
+			close(server);
+			signal(SIGCHLD,SIG_DFL);
+
+			dup2(conn,0);
+			dup2(conn,1);
+			close(conn);
+
+			sprintf(g_io->logfile,"log%d_%s.txt",(int) getpid(),machine->gamedrv->name);
+			g_fork_path[0]='\0';
+			g_snap_owner=FALSE;					//Schnappschuss gehoert dem Server
+			g_snap_tag^=(UINT32) getpid();		//Eigene Dateien je Halbzug
+			return;
+		}
+
+		if (pid<0)
+			fprintf(stderr,"fork server: fork failed\n");
+		close(conn);
+	}
+#else
+	g_fork_path[0]='\0';						//Nur Linux
+#endif
+}
+
+//------------------------------
+// ForkConnect
+//------------------------------
+// Client: stdin -> Socket, Socket -> stdout, bis eine Seite schliesst
+//
+static int ForkConnect(const char *path)
+{
+#if defined linux
+	struct sockaddr_un addr;
+	struct pollfd fds[2];
+	char buffer[4096];
+	int sock;
+	int len;
+
+	sock=socket(AF_UNIX,SOCK_STREAM,0);
+	memset(&addr,0,sizeof(addr));
+	addr.sun_family=AF_UNIX;
+	strncpy(addr.sun_path,path,sizeof(addr.sun_path)-1);
+
+	if (sock<0 || connect(sock,(struct sockaddr *) &addr,sizeof(addr))<0)
+	{
+		fprintf(stderr,"fork server %s not available\n",path);
+		return MAMERR_FATALERROR;
+	}
+
+	fds[0].fd=0;
+	fds[0].events=POLLIN;
+	fds[1].fd=sock;
+	fds[1].events=POLLIN;
+
+	while (poll(fds,2,-1)>0)
+	{
+		if (fds[0].revents & (POLLIN|POLLHUP))
+		{
+			len=read(0,buffer,sizeof(buffer));
+			if (len<=0)
+				shutdown(sock,SHUT_WR);		//Engine sieht EOF
+			else if (write(sock,buffer,len)!=len)
+				break;
+			if (len<=0)
+				fds[0].fd=-1;
+		}
+		if (fds[1].revents & (POLLIN|POLLHUP))
+		{
+			len=read(sock,buffer,sizeof(buffer));
+			if (len<=0 || write(1,buffer,len)!=len)
+				break;
+		}
+	}
+
+	close(sock);
+	return MAMERR_NONE;
+#else
+	fprintf(stderr,"fork server only available on linux\n");
+	return MAMERR_FATALERROR;
+#endif
+}
+
+//------------------------------
+// LoadSymbols                                          
+//------------------------------
+// Symbole des Moduls aus sym_<modul>.txt lesen
+// Format je Zeile: <name> <wert>  z.B. bestmove 0x0123, Kommentar mit # oder ;
+// Es gibt keine Vorgaben im Programm: ohne Datei sind alle Adressen 0, Bestmove, Info,
+// Abbruch und Brett laufen dann wie bisher ueber Display und Tasten
+//
+static void LoadSymbols(const char *module)
+{
+	FILE *fp;
+	char filename[40];
+	char line[100];
+	char name[40];
+	char value[40];
+	char *p;
+	UINT32 v;
+	int i;
+
+	memset(&g_sym,0,sizeof(g_sym));
+	strncpy(g_sym.module,module,sizeof(g_sym.module)-1);
+	g_sym.sq_type=SQ_64;
+	g_sym.side_white=1;
+	g_sym.ep_none=0xff;
+
+	sprintf(filename,"sym_%s.txt",module);
+
+	fp=fopen(filename,"r");
+	if (fp==NULL)
+	{
+		Log("%s not found, no RAM symbols\n",filename);
+		return;
+	}
+
+	while (fgets(line,sizeof(line),fp)!=NULL)
+	{
+		if (line[0]=='#' || line[0]==';')
+			continue;
+
+		if (sscanf(line,"%39s %39s",name,value)!=2)
+			continue;
+
+		v=strtoul(value,NULL,0);
+
+		if		(!strcmp(name,"bestmove"))		g_sym.bestmove=v;
+		else if (!strcmp(name,"pv"))			g_sym.pv=v;
+		else if (!strcmp(name,"pv_len"))		g_sym.pv_len=MIN(v,SYM_PV_MAX);
+		else if (!strcmp(name,"depth"))			g_sym.depth=v;
+		else if (!strcmp(name,"score"))			g_sym.score=v;
+		else if (!strcmp(name,"nodes"))			g_sym.nodes=v;
+		else if (!strcmp(name,"big_endian"))	g_sym.big_endian=v;
+		else if (!strcmp(name,"sq_type"))		g_sym.sq_type=v;
+		else if (!strcmp(name,"stop"))			g_sym.stop=v;
+		else if (!strcmp(name,"stop_value"))	g_sym.stop_value=v;
+		else if (!strcmp(name,"board"))			g_sym.board=v;
+		else if (!strcmp(name,"board2"))		g_sym.board2=v;
+		else if (!strcmp(name,"side"))			g_sym.side=v;
+		else if (!strcmp(name,"side_white"))	g_sym.side_white=v;
+		else if (!strcmp(name,"side_black"))	g_sym.side_black=v;
+		else if (!strcmp(name,"castle"))		g_sym.castle=v;
+		else if (!strcmp(name,"ep"))			g_sym.ep=v;
+		else if (!strcmp(name,"ep_none"))		g_sym.ep_none=v;
+		else if (!strcmp(name,"pieces"))									//z.B. pieces 0,1,2,3,4,5,6,9,10,11,12,13,14
+		{
+			p=value;
+			for (i=0; i<SYM_PIECES && *p!='\0'; i++)
+			{
+				g_sym.pieces[i]=strtoul(p,&p,0);
+				if (*p==',')
+					p++;
+			}
+		}
+		else
+			Log("%s: unknown symbol %s\n",filename,name);
+	}
+	fclose(fp);
+
+	PrintAndLog("Symbols loaded      : %s\n",filename);
+	Log("bestmove: 0x%x pv: 0x%x/%d depth: 0x%x score: 0x%x nodes: 0x%x big_endian: %d sq_type: %d stop: 0x%x/0x%x\n",
+		g_sym.bestmove,g_sym.pv,g_sym.pv_len,g_sym.depth,g_sym.score,g_sym.nodes,g_sym.big_endian,g_sym.sq_type,
+		g_sym.stop,g_sym.stop_value);
+	Log("board: 0x%x/0x%x side: 0x%x castle: 0x%x ep: 0x%x\n",g_sym.board,g_sym.board2,g_sym.side,g_sym.castle,g_sym.ep);
+}
+
+//------------------------------
+// SymRead                                          
+//------------------------------
+// 1,2 oder 4 Byte aus dem RAM der Emulation lesen
+//
+static UINT32 SymRead(running_machine *machine, offs_t addr, int size)
+{
+	const address_space *space = cputag_get_address_space(machine, "maincpu", ADDRESS_SPACE_PROGRAM);
+	UINT32 data=0;
+	int i;
+
+	for (i=0; i<size; i++)
+	{
+		if (g_sym.big_endian)
+			data = (data<<8) | memory_read_byte(space,addr+i);
+		else
+			data |= (UINT32) memory_read_byte(space,addr+i) << (8*i);
+	}
+
+	return data;
+}
+
+//------------------------------
+// SymSquare                                          
+//------------------------------
+// Feldnummer im Format des Moduls in z.B. "e2" umwandeln
+//
+static int SymSquare(int sq, char *field)
+{
+	int file;
+	int rank;
+
+	switch (g_sym.sq_type)
+	{
+		case SQ_MM:
+			file=sq/10;
+			rank=sq%10-1;
+			break;
+		case SQ_0X88:
+			if (sq & 0x88)
+				return FALSE;
+			file=sq & 7;
+			rank=sq>>4;
+			break;
+		default:
+			file=sq & 7;
+			rank=sq>>3;
+			break;
+	}
+
+	if (file<0 || file>7 || rank<0 || rank>7)
+		return FALSE;
+
+	field[0]='a'+file;
+	field[1]='1'+rank;
+	field[2]='\0';
+
+	return TRUE;
+}
+
+//------------------------------
+// SymReadBestmove                                          
+//------------------------------
+// Bestmove direkt aus dem RAM lesen, FALSE -> Adresse unbekannt oder kein gueltiger Zug
+//
+int SymReadBestmove(running_machine *machine, char *move)
+{
+	int from;
+	int to;
+
+	if (!g_sym.bestmove)
+		return FALSE;
+
+	from=SymRead(machine,g_sym.bestmove,1);
+	to  =SymRead(machine,g_sym.bestmove+1,1);
+
+	if (from==to || !SymSquare(from,&move[0]) || !SymSquare(to,&move[2]))
+		return FALSE;
+
+	return TRUE;
+}
+
+//------------------------------
+// SymReadInfo                                          
+//------------------------------
+// Infozeile aus dem RAM, FALSE -> keine Adressen bekannt, dann Infozeile ueber das Display
+//
+static int SymReadInfo(running_machine *machine, XCMD_INFO_T *info)
+{
+	char field[3];
+	int i;
+
+	if (!g_sym.depth && !g_sym.score && !g_sym.nodes && !g_sym.pv)
+		return FALSE;
+
+	strcpy(info->ply,"1");
+	strcpy(info->score,"0");
+	strcpy(info->time,"0");
+	strcpy(info->nodes,"0");
+	info->PV[0]='\0';
+
+	if (g_sym.depth)
+		sprintf(info->ply,"%d",SymRead(machine,g_sym.depth,1));
+
+	if (g_sym.score)
+		sprintf(info->score,"%d",(INT16) SymRead(machine,g_sym.score,2));
+
+	if (g_sym.nodes)
+		sprintf(info->nodes,"%u",SymRead(machine,g_sym.nodes,4));
+
+	if (g_tc.starttime)
+		sprintf(info->time,"%d",(int) TimeUsed(machine,&g_tc)/10);		//Centisekunden
+
+	for (i=0; i<g_sym.pv_len; i++)
+	{
+		if (!SymSquare(SymRead(machine,g_sym.pv+2*i,1),field))
+			break;
+		if (i>0)
+			strcat(info->PV," ");
+		strcat(info->PV,field);
+
+		if (!SymSquare(SymRead(machine,g_sym.pv+2*i+1,1),field))
+			break;
+		strcat(info->PV,field);
+	}
+
+	return TRUE;
+}
+
+//------------------------------
+// SymWrite                                          
+//------------------------------
+static void SymWrite(running_machine *machine, offs_t addr, UINT8 data)
+{
+	memory_write_byte(cputag_get_address_space(machine, "maincpu", ADDRESS_SPACE_PROGRAM),addr,data);
+}
+
+//------------------------------
+// SymOffset                                          
+//------------------------------
+// Gegenstueck zu SymSquare: Feld (a1=0, h8=63) im Format des Moduls
+//
+static int SymOffset(int sq)
+{
+	switch (g_sym.sq_type)
+	{
+		case SQ_MM:
+			return (sq&7)*10+(sq>>3)+1;
+		case SQ_0X88:
+			return ((sq>>3)<<4) | (sq&7);
+		default:
+			return sq;
+	}
+}
+
+//------------------------------
+// SymSetBoard                                          
+//------------------------------
+// Stellung aus dem FEN direkt ins RAM, FALSE -> Brett unbekannt bzw. FEN fehlerhaft, dann ueber Tasten
+//
+static int SymSetBoard(running_machine *machine, const char *FEN)
+{
+	static const char piece_chars[]="PNBRQKpnbrqk";
+	static const char castle_chars[]="KQkq";
+	UINT8 board[64];							//a1=0
+	char pieces[100];
+	char side='w';
+	char castle[5]="-";
+	char ep[3]="-";
+	const char *p;
+	const char *q;
+	int file=0;
+	int rank=7;
+	int sq;
+	UINT8 rights=0;
+
+	if (!g_sym.board || !g_sym.pieces[6] || !g_sym.pieces[12])		//Mindestens Figurcodes der Koenige
+		return FALSE;
+
+	if (sscanf(FEN,"%99s %c %4s %2s",pieces,&side,castle,ep) < 2)
+		return FALSE;
+
+	memset(board,0,sizeof(board));
+
+	for (p=pieces; *p!='\0'; p++)
+	{
+		if (*p=='/')
+		{
+			if (file!=8 || rank==0)
+				return FALSE;
+			rank--;
+			file=0;
+		}
+		else if (isdigit((UINT8) *p))
+			file+=*p-'0';
+		else if ((q=strchr(piece_chars,*p))!=NULL && file<8)
+			board[rank*8+file++]=q-piece_chars+1;
+		else
+			return FALSE;
+
+		if (file>8)
+			return FALSE;
+	}
+	if (rank!=0 || file!=8)
+		return FALSE;
+
+	for (sq=0; sq<64; sq++)
+	{
+		SymWrite(machine,g_sym.board+SymOffset(sq),g_sym.pieces[board[sq]]);
+		if (g_sym.board2)
+			SymWrite(machine,g_sym.board2+SymOffset(sq),g_sym.pieces[board[sq]]);
+	}
+
+	if (g_sym.side)
+		SymWrite(machine,g_sym.side,(side=='b') ? g_sym.side_black : g_sym.side_white);
+
+	if (g_sym.castle)
+	{
+		for (p=castle; *p!='\0'; p++)
+		{
+			if ((q=strchr(castle_chars,*p))!=NULL)
+				rights|=1<<(q-castle_chars);
+		}
+		SymWrite(machine,g_sym.castle,rights);
+	}
+
+	if (g_sym.ep)
+	{
+		if (ep[0]>='a' && ep[0]<='h' && ep[1]>='1' && ep[1]<='8')
+			SymWrite(machine,g_sym.ep,SymOffset((ep[1]-'1')*8+ep[0]-'a'));
+		else
+			SymWrite(machine,g_sym.ep,g_sym.ep_none);
+	}
+
+	return TRUE;
+}
+
+//------------------------------
+// SetBoardDirect                                          
+//------------------------------
+// setboard ohne Tastenfolge: zuerst der Treiber, sonst ueber die Symboltabelle
+//
+static int SetBoardDirect(running_machine *machine, char *FEN)
+{
+	if (!g_setboard)
+		return FALSE;
+
+	if (g_bridge.set_board!=NULL && g_bridge.set_board(machine,FEN))
+		return TRUE;
+
+	return SymSetBoard(machine,FEN);
+}
+
+//------------------------------
+// PostEvent                                          
+//------------------------------
+// Wird vom Treiber aufgerufen (Emulationsthread), Zeitstempel = lokale Zeit der CPU
+// Die Zeitscheibe wird abgebrochen, damit die Bridge sofort reagiert
+// Displaywechsel nur bei offenem Tastendruck, sonst bei jeder Anzeige der Suche ein Abbruch
+//
+void PostEvent(running_machine *machine, int type)
+{
+	EMU_EVENT_T *ev;
+
+	if (g_ev_head - g_ev_tail >= EV_QUEUE_SIZE)
+	{
+		Log("Event queue full, event %d lost\n",type);
+		return;
+	}
+
+	ev=&g_ev_queue[g_ev_head & (EV_QUEUE_SIZE-1)];
+	ev->type=type;
+	ev->time=timer_get_time(machine);
+	strncpy(ev->display,g_display,4);
+	ev->display[4]='\0';
+
+	g_ev_head++;
+
+	if (type!=EV_DISPLAY_SETTLED || g_ev_key_pending)
+		cpuexec_abort_timeslice(machine);
+}
+
+//------------------------------
+// EvLatency                                          
+//------------------------------
+static void EvLatency(EV_STAT_T *stat, attotime start, attotime end)
+{
+	UINT64 us;
+
+	us=(UINT64) (attotime_to_double(attotime_sub(end,start)) * 1000000.0);
+
+	stat->count++;
+	stat->sum+=us;
+	if (us > stat->max)
+		stat->max=us;
+}
+
+//------------------------------
+// ProcessEvents                                          
+//------------------------------
+// Ereignisse des Treibers auswerten, Aufruf vor jeder Zeitscheibe
+//
+static void ProcessEvents(running_machine *machine)
+{
+	EMU_EVENT_T *ev;
+	char symmove[10];
+
+	while (g_ev_tail != g_ev_head)
+	{
+		ev=&g_ev_queue[g_ev_tail & (EV_QUEUE_SIZE-1)];
+		g_ev_tail++;
+
+		switch (ev->type)
+		{
+			case EV_DISPLAY_SETTLED:
+				if (g_ev_key_pending)							//Rueckmeldung Tastendruck
+				{
+					EvLatency(&g_ev_stat_key,g_ev_key_time,ev->time);
+					g_ev_key_pending=FALSE;
+				}
+				g_ev_display=ev->time;
+				break;
+
+			case EV_SEARCH_ENDED:
+				if (g_state==PONDERING && g_ponder_display[0]!='\0')	//Nicht der Tastenklick von ENT
+					g_ponder_ended=TRUE;
+
+				if (g_state==SEARCHING && !g_search_ended)
+				{
+					OvhSearchEnd();
+					g_search_ended=TRUE;
+					g_ev_end_valid=TRUE;
+					g_ev_search_end=ev->time;
+					g_ev_display=ev->time;						//Display ab Ende Suche stabil ?
+				}
+				break;
+
+			case EV_ERROR_SHOWN:
+				Log("Event: error %s\n",ev->display);
+				g_hs_fail++;
+				g_search_ended=FALSE;
+				break;
+		}
+	}
+
+// Bestmove sobald das Display nach Ende der Suche g_settle_us stabil ist
+// Sonst (MAT, PATT, ...) wie bisher ueber BM_Check im Treiber
+//
+	if (g_search_ended)
+	{
+		if (g_state!=SEARCHING || g_settle_us==0)
+			g_search_ended=FALSE;
+		else if (attotime_compare(attotime_sub(timer_get_time(machine),g_ev_display),ATTOTIME_IN_USEC(g_settle_us)) >= 0 &&
+				 (TestMove(g_display) || SymReadBestmove(machine,symmove)) )
+		{
+			LogDebug("Event: bestmove %s\n",g_display);
+
+			g_search_ended=FALSE;
+			g_state=BESTMOVE;
+
+			if (g_bridge.bm_reset!=NULL)
+				g_bridge.bm_reset();
+		}
+	}
+}
+
+//------------------------------
+// KeypadReset                                          
+//------------------------------
+static void KeypadReset(void)
+{
+	g_keypad_head=g_keypad_tail=0;
+	g_keypad_phase=KEYPAD_IDLE;
+}
+
+//------------------------------
+// KeypadNext                                          
+//------------------------------
+// Naechste Taste der Warteschlange druecken, leer -> Eingabe fertig (Wartezeiten ab hier)
+//
+static void KeypadNext(running_machine *machine)
+{
+	EMU_KEY_T *key;
+
+	if (g_keypad_tail==g_keypad_head)
+	{
+		g_keypad_phase=KEYPAD_IDLE;
+		g_portIsReady=TRUE;
+		g_waitCnt=0;
+		return;
+	}
+
+	key=&g_keypad_queue[g_keypad_tail & (KEYPAD_QUEUE_SIZE-1)];
+	input_port_set(machine,key->name,key->data);
+
+	g_keypad_phase=KEYPAD_PRESSED;
+	g_keypad_scans=0;
+	g_keypad_time=timer_get_time(machine);
+}
+
+//------------------------------
+// KeypadPress                                          
+//------------------------------
+// Ohne -mmkeyscans Taste sofort setzen, losgelassen wird im Treiber (Display bzw. g_inputTimeout)
+//
+void KeypadPress(running_machine *machine, EMU_KEY_T *key)
+{
+	if (g_keyscans==0)
+	{
+		input_port_set(machine,key->name,key->data);
+		return;
+	}
+
+	if (g_keypad_head - g_keypad_tail >= KEYPAD_QUEUE_SIZE)
+	{
+		Log("Keypad queue full, key %s %d lost\n",key->name,key->data);
+		return;
+	}
+
+	g_keypad_queue[g_keypad_head & (KEYPAD_QUEUE_SIZE-1)]=*key;
+	g_keypad_head++;
+	g_portIsReady=FALSE;
+
+	if (g_keypad_phase==KEYPAD_IDLE)
+		KeypadNext(machine);
+}
+
+//------------------------------
+// KeypadScan                                          
+//------------------------------
+// Aufruf vom Treiber bei jeder Abfrage einer Tastenzeile durch das ROM
+// select = abgefragte Taste der Zeile (Glasgow), -1 = ganze Zeile
+//
+void KeypadScan(running_machine *machine, const char *row, int select)
+{
+	EMU_KEY_T *key;
+
+	if (g_keypad_phase==KEYPAD_IDLE)
+		return;
+
+	key=&g_keypad_queue[g_keypad_tail & (KEYPAD_QUEUE_SIZE-1)];
+	if (strcmp(row,key->name) || (select>=0 && select!=key->data))
+		return;
+
+	if (++g_keypad_scans < g_keyscans)
+		return;
+
+	if (g_keypad_phase==KEYPAD_PRESSED)						//Gesehen -> loslassen
+	{
+		input_port_clear(machine,key->name);
+		EvLatency(&g_ev_stat_scan,g_keypad_time,timer_get_time(machine));
+
+		g_keypad_phase=KEYPAD_GAP;
+		g_keypad_scans=0;
+	}
+	else													//Loslassen gesehen -> naechste Taste
+	{
+		g_keypad_tail++;
+		KeypadNext(machine);
+	}
+}
+
+//------------------------------
+// StopSearch                                          
+//------------------------------
+// Suche abbrechen (Zeit, ?, Zyklen): Stopflag des ROMs direkt ins RAM (Symbol stop),
+// ohne bekanntes Flag ueber die Taste ENT
+//
+static void StopSearch(running_machine *machine)
+{
+	const address_space *space;
+
+	if (g_sym.stop)
+	{
+		space=cputag_get_address_space(machine,"maincpu",ADDRESS_SPACE_PROGRAM);
+		memory_write_byte(space,g_sym.stop,g_sym.stop_value);
+		LogDebug("Stop flag 0x%x = 0x%x\n",g_sym.stop,g_sym.stop_value);
+	}
+	else
+		KeypadPress(machine,GetKeycode(g_keys,'s'));
+
+	g_break_search=TRUE;
+
+	g_stop_pending=TRUE;
+	g_stop_time=timer_get_time(machine);
+	g_stop_wall=GetTime();
+}
+
+//------------------------------
+// StopBestSoFar                                          
+//------------------------------
+// Bester Zug der laufenden Suche: RAM (bestmove, pv), sonst erster Zug der letzten Infozeile
+//
+static int StopBestSoFar(running_machine *machine, char *move)
+{
+	if (SymReadBestmove(machine,move))
+		return TRUE;
+
+	if (g_sym.pv &&
+		SymSquare(SymRead(machine,g_sym.pv,1),&move[0]) &&
+		SymSquare(SymRead(machine,g_sym.pv+1,1),&move[2]))
+		return TRUE;
+
+	strncpy(move,xcmd_info.PV,4);
+	move[4]='\0';
+	if (!TestMove(move))
+		return FALSE;
+
+	move[0]=tolower(move[0]);
+	move[2]=tolower(move[2]);
+
+	return TRUE;
+}
+
+//------------------------------
+// StopPromo                                          
+//------------------------------
+// Zug auf die letzte Reihe: Bauer auf dem Ausgangsfeld laut Brett im RAM -> 'q' anhaengen
+// Rueckgabe FALSE -> Figur unbekannt (kein board in der Symboltabelle), Zug nicht sendbar
+//
+static int StopPromo(running_machine *machine, char *move)
+{
+	UINT8 piece;
+	int sq=(move[1]-'1')*8+(move[0]-'a');
+
+	if (!checkPromo(move))
+		return TRUE;
+
+	if (!g_sym.board || !g_sym.pieces[1] || !g_sym.pieces[7])
+		return FALSE;
+
+	piece=(UINT8) SymRead(machine,g_sym.board+SymOffset(sq),1);
+	if (piece==g_sym.pieces[1] || piece==g_sym.pieces[7])
+		strcat(move,"q");												//Ohne Abfrage der Promofigur: Dame
+
+	return TRUE;
+}
+
+//------------------------------
+// StopDeadline                                          
+//------------------------------
+// Kein Zug innerhalb -mmstopdeadline ms nach dem Abbruch -> besten Zug bisher senden
+// Gemessen in Emulatorzeit bei -mmvclock, sonst in Echtzeit wie die Uhr der GUI
+// Danach bleibt die Bridge in SEARCHING, bis das ROM die Suche beendet (Pruefung in ProcessBESTMOVE)
+// Rueckgabe TRUE -> Zug ist gesendet, keine weitere Auswertung der Suche
+//
+static int StopDeadline(running_machine *machine)
+{
+	char move[10];
+	char buffer[12];
+
+	if (g_stop_move[0]!='\0')											//Warten auf das Ende der Suche im ROM
+		return TRUE;
+
+	if (!g_stop_pending || g_stop_deadline==0)
+		return FALSE;
+
+	if (g_vclock ? attotime_compare(attotime_sub(timer_get_time(machine),g_stop_time),ATTOTIME_IN_MSEC(g_stop_deadline)) < 0
+				 : GetTime()-g_stop_wall < g_stop_deadline)
+		return FALSE;
+
+	if (!StopBestSoFar(machine,move))
+	{
+		Log("Stop deadline %u ms exceeded, no move known (display %s)\n",g_stop_deadline,g_display);
+		g_stop_pending=FALSE;
+		return FALSE;
+	}
+
+	if (!StopPromo(machine,move))										//Umwandlung ? Dann auf das ROM warten
+	{
+		Log("Stop deadline %u ms exceeded, %s may be a promotion, waiting for the ROM\n",g_stop_deadline,move);
+		g_stop_pending=FALSE;
+		return FALSE;
+	}
+
+	Log("Stop deadline %u ms exceeded, best move so far: %s (display %s)\n",g_stop_deadline,move,g_display);
+
+	strcpy(g_stop_move,move);
+	g_stop_forced++;
+
+	sprintf(buffer,"%s\n",move);
+	SendBestmoveToGUI(buffer);
+	return TRUE;
+}
+
+//------------------------------
+// StopMoveCheck                                          
+//------------------------------
+// Ende der Suche nach einem Zug aus StopDeadline: hat das ROM den gesendeten Zug gespielt ?
+// Sonst ROM-Zug im force Modus zuruecknehmen (9), gesendeten Zug eingeben und force verlassen (r)
+//
+static void StopMoveCheck(running_machine *machine, const char *rommove)
+{
+	char rom[5];
+	int i;
+
+	for (i=0; i<4 && rommove[i]!='\0'; i++)
+		rom[i]=tolower(rommove[i]);
+	rom[i]='\0';
+
+	PlyAdvance();
+	g_bestmove[0]='\0';
+	g_state=DRIVER_READY;
+
+	if (!TestMove(rom))
+		Log("Stop deadline: search ended without move (display %s), sent %s\n",g_display,g_stop_move);
+	else if (!strncmp(rom,g_stop_move,4))
+		Log("Stop deadline: ROM played %s as sent\n",rom);
+	else
+	{
+		Log("Stop deadline: ROM played %s, sent %s -> correct module\n",rom,g_stop_move);
+		g_stop_fixed++;
+
+		strcpy(g_cmd,xcmd_force);
+		strcat(g_cmd,"9");
+		strncat(g_cmd,g_stop_move,4);
+		strcat(g_cmd,"s");
+		if (g_stop_move[4]=='q')
+		{
+			strcat(g_cmd,xcmd_promo_q);
+			strcat(g_cmd,"s");
+		}
+		strcat(g_cmd,"r");
+
+		g_cmd_inx=0;
+		g_cmd_len=strlen(g_cmd);
+		g_start_search=FALSE;
+		g_cmd_internal=TRUE;
+		g_state=SENDCOMMAND;
+	}
+
+	g_stop_move[0]='\0';
+}
+
+//------------------------------
+// LogEventStat                                          
+//------------------------------
+static void LogEventStat(void)
+{
+	Log("Latency search end -> bestmove: %u x avg %u us max %u us\n",g_ev_stat_bm.count,
+		g_ev_stat_bm.count ? (UINT32) (g_ev_stat_bm.sum/g_ev_stat_bm.count) : 0,(UINT32) g_ev_stat_bm.max);
+	Log("Latency key -> display        : %u x avg %u us max %u us\n",g_ev_stat_key.count,
+		g_ev_stat_key.count ? (UINT32) (g_ev_stat_key.sum/g_ev_stat_key.count) : 0,(UINT32) g_ev_stat_key.max);
+	Log("Latency key press -> release  : %u x avg %u us max %u us\n",g_ev_stat_scan.count,
+		g_ev_stat_scan.count ? (UINT32) (g_ev_stat_scan.sum/g_ev_stat_scan.count) : 0,(UINT32) g_ev_stat_scan.max);
+	Log("Latency stop -> bestmove      : %u x avg %u us max %u us, %u after deadline (%u corrected)\n",g_ev_stat_stop.count,
+		g_ev_stat_stop.count ? (UINT32) (g_ev_stat_stop.sum/g_ev_stat_stop.count) : 0,(UINT32) g_ev_stat_stop.max,g_stop_forced,g_stop_fixed);
+}
+
+//------------------------------
+// CalibKey
+//------------------------------
+// FNV Hash ueber Modul, Takt, Build und CPU Modell
+//
+static void CalibKey(const char *module)
+{
+	char cpu[128]="unknown";
+	char line[256];
+	char key[512];
+	UINT32 hash=2166136261U;
+	char *p;
+
+#if defined linux
+	FILE *fp;
+
+	fp=fopen("/proc/cpuinfo","r");
+	if (fp!=NULL)
+	{
+		while (fgets(line,sizeof(line),fp)!=NULL)
+			if (!strncmp(line,"model name",10) && (p=strchr(line,':'))!=NULL)
+			{
+				strncpy(cpu,p+2,sizeof(cpu)-1);
+				break;
+			}
+		fclose(fp);
+	}
+#else
+	if ((p=getenv("PROCESSOR_IDENTIFIER"))!=NULL)
+		strncpy(cpu,p,sizeof(cpu)-1);
+#endif
+	cpu[sizeof(cpu)-1]='\0';
+	if ((p=strpbrk(cpu,"\r\n"))!=NULL)
+		*p='\0';
+
+	snprintf(key,sizeof(key),"%s|%d|%s|%s",module,g_clock,build_version,cpu);
+	for (p=key; *p!='\0'; p++)
+		hash=(hash ^ (UINT8) *p) * 16777619U;
+
+	sprintf(g_calib_key,"%08x",hash);
+}
+
+//------------------------------
+// CalibLoad
+//------------------------------
+// Rueckgabe gespeicherte Zeit fuer eine Sekunde (ms), 0 = nicht vorhanden
+//
+static int CalibLoad(const char *module)
+{
+	FILE *fp;
+	char key[12];
+	int time_per_sec=0;
+
+	CalibKey(module);
+
+	fp=fopen(CALIB_FILE,"r");
+	if (fp==NULL)
+		return 0;
+
+	while (fscanf(fp,"%11s %d %*[^\n]",key,&time_per_sec)==2)
+	{
+		if (!strcmp(key,g_calib_key) && time_per_sec>0)
+		{
+			fclose(fp);
+			return time_per_sec;
+		}
+		time_per_sec=0;
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+//------------------------------
+// CalibSave
+//------------------------------
+// Eintrag ersetzen bzw. anhaengen
+//
+static void CalibSave(const char *module, int time_per_sec)
+{
+	FILE *fp;
+	char lines[64][80];
+	char tmpfile[40];
+	int count=0;
+	int i;
+
+	fp=fopen(CALIB_FILE,"r");
+	if (fp!=NULL)
+	{
+		while (count<64 && fgets(lines[count],sizeof(lines[0]),fp)!=NULL)
+			if (strncmp(lines[count],g_calib_key,8))
+				count++;
+		fclose(fp);
+	}
+
+// Erst in eine eigene Datei schreiben, dann umbenennen
+// Mehrere Prozesse (EPD, Fork Server) sehen so immer eine vollstaendige Datei
+//
+	sprintf(tmpfile,"%s.%08x",CALIB_FILE,(UINT32) osd_ticks() ^ g_snap_tag);
+
+	fp=fopen(tmpfile,"w");
+	if (fp==NULL)
+		return;
+
+	for (i=(count==64); i<count; i++)					//Voll -> aeltesten Eintrag verwerfen
+		fputs(lines[i],fp);
+	fprintf(fp,"%s %d %s %d\n",g_calib_key,time_per_sec,module,g_clock);
+
+	if (fclose(fp)!=0)
+	{
+		remove(tmpfile);
+		return;
+	}
+
+#if !defined linux
+	remove(CALIB_FILE);									//rename ersetzt unter Windows nicht
+#endif
+	if (rename(tmpfile,CALIB_FILE)!=0)
+	{
+		remove(tmpfile);
+		return;
+	}
+
+	Log("Calibration saved: %s %d ms\n",g_calib_key,time_per_sec);
+}
+
+//------------------------------
+// CalibCheck
+//------------------------------
+// Waehrend der ersten Suche nachmessen (wie ProcessDRIVER_START), nur wenn der Wert aus dem Cache kommt
+//
+static void CalibCheck(running_machine *machine)
+{
+	UINT64 now;
+	int time_per_sec;
+
+	if (!g_calib_cached)
+		return;
+
+	now=GetTime();
+
+	if (g_calib_start==0 || now-g_calib_last > 50 || g_waitCnt < g_calib_cnt)	//Suche unterbrochen -> neu starten
+	{
+		g_calib_start=now;
+		g_calib_last=now;
+		g_calib_cnt=g_waitCnt;
+		return;
+	}
+	g_calib_last=now;
+
+	if (g_waitCnt-g_calib_cnt < CALIB_WAIT)
+		return;
+
+	g_calib_cached=FALSE;
+	time_per_sec=(int) (now-g_calib_start)/10;
+
+	if (abs(time_per_sec-g_time_per_sec)*100 <= g_time_per_sec*CALIB_DRIFT)
+	{
+		Log("Calibration confirmed: %d ms (cache %d ms)\n",time_per_sec,g_time_per_sec);
+		return;
+	}
+
+	Log("Calibration drift: %d ms (cache %d ms)\n",time_per_sec,g_time_per_sec);
+
+	g_time_per_sec=time_per_sec;
+	g_time_corr=(float) g_time_per_sec/TC_DELAY_REF;
+	g_tc_delay=g_calib_tc_delay * g_time_corr;
+
+	CalibSave(machine->gamedrv->name,g_time_per_sec);
+}
+
+//------------------------------
+// HsGet / HsSet
+//------------------------------
+// Reihenfolge wie in hs_<modul>.txt: bestmove, special, input, promo, timeout
+//
+static void HsGet(int *w)
+{
+	w[0]=g_bestmoveWait;
+	w[1]=g_specialWait;
+	w[2]=g_inputWait;
+	w[3]=g_promoWait;
+	w[4]=g_inputTimeout;
+}
+
+static void HsSet(const int *w)
+{
+	g_bestmoveWait=w[0];
+	g_specialWait=w[1];
+	g_inputWait=w[2];
+	g_promoWait=w[3];
+	g_inputTimeout=w[4];
+}
+
+//------------------------------
+// HsLoad
+//------------------------------
+// Profil aus -mmtune fuer Modus und Takt, sonst bleiben die Werte der Modultabelle
+//
+static void HsLoad(const char *module)
+{
+	FILE *fp;
+	char file[40];
+	char mode;
+	int clock;
+	int w[5];
+
+	sprintf(file,HS_FILE,module);
+
+	fp=fopen(file,"r");
+	if (fp==NULL)
+		return;
+
+	while (fscanf(fp," %c %d %d %d %d %d %d",&mode,&clock,&w[0],&w[1],&w[2],&w[3],&w[4])==7)
+	{
+		if (mode==(g_unlimited ? 'u' : 'r') && clock==g_clock)
+		{
+			HsSet(w);
+			Log("Handshake profile: %s %c %d: %d %d %d %d %d\n",file,mode,clock,w[0],w[1],w[2],w[3],w[4]);
+			break;
+		}
+	}
+	fclose(fp);
+}
+
+//------------------------------
+// HsSave
+//------------------------------
+// Eintrag fuer Modus und Takt ersetzen bzw. anhaengen
+//
+static void HsSave(const char *module)
+{
+	FILE *fp;
+	char file[40];
+	char lines[16][80];
+	char mode;
+	int clock;
+	int count=0;
+	int i;
+
+	sprintf(file,HS_FILE,module);
+
+	fp=fopen(file,"r");
+	if (fp!=NULL)
+	{
+		while (count<16 && fgets(lines[count],sizeof(lines[0]),fp)!=NULL)
+			if (sscanf(lines[count]," %c %d",&mode,&clock)==2 &&
+				(mode!=(g_unlimited ? 'u' : 'r') || clock!=g_clock))
+				count++;
+		fclose(fp);
+	}
+
+	fp=fopen(file,"w");
+	if (fp==NULL)
+		return;
+
+	for (i=0; i<count; i++)
+		fputs(lines[i],fp);
+	fprintf(fp,"%c %d %d %d %d %d %d\n",g_unlimited ? 'u' : 'r',g_clock,
+		g_bestmoveWait,g_specialWait,g_inputWait,g_promoWait,g_inputTimeout);
+	fclose(fp);
+
+	Log("Handshake profile saved: %s\n",file);
+}
+
+//------------------------------
+// HsCommand
+//------------------------------
+// mmwaits					-> Antwort mmwaits <Fehler> <Wartezeiten>, Fehlerzaehler auf 0
+// mmwaits b s i p t		-> setzen
+// mmwaits default | save	-> Werte der Modultabelle | Profil schreiben
+//
+static void HsCommand(running_machine *machine, char *arg)
+{
+	char line[80];
+	int w[5];
+	int i;
+
+	if (arg==NULL)
+	{
+		HsGet(w);
+		sprintf(line,"mmwaits %u %d %d %d %d %d\n",g_hs_fail,w[0],w[1],w[2],w[3],w[4]);
+		g_hs_fail=0;
+		SendToGUI(line);
+	}
+	else if (!strcmp(arg,"default"))
+		HsSet(g_hs_default);
+	else if (!strcmp(arg,"save"))
+		HsSave(machine->gamedrv->name);
+	else
+	{
+		HsGet(w);
+		for (i=0; i<5 && arg!=NULL; i++, arg=StrTok(NULL," ",&g_cmd_tok))
+			w[i]=atoi(arg);
+		HsSet(w);
+	}
+}
+
+//------------------------------
+// SnapCapture
+//------------------------------
+// Zustand nach dem Start sichern, Rueckgabe FALSE = spaeter nochmal versuchen
+//
+static int SnapCapture(running_machine *machine)
+{
+	file_error filerr;
+	state_save_error staterr;
+	mame_file *file;
+
+	if (timer_count_anonymous(machine) > 0)										//Wie handle_save: erst ohne anonyme Timer
+	{
+		if (attotime_compare(timer_get_time(machine),ATTOTIME_IN_MSEC(SNAP_BOOT_MS+1000)) < 0)
+			return FALSE;
+		Log("Snapshot: pending anonymous timers, disabled\n");
+		g_snapshot=0;
+		return TRUE;
+	}
+
+	filerr=mame_fopen(SEARCHPATH_STATE,g_snap_name,OPEN_FLAG_WRITE|OPEN_FLAG_CREATE|OPEN_FLAG_CREATE_PATHS,&file);
+	if (filerr!=FILERR_NONE)
+	{
+		Log("Snapshot: cannot create %s, disabled\n",g_snap_name);
+		g_snapshot=0;
+		return TRUE;
+	}
+
+	astring fullname(mame_file_full_name(file));
+
+	staterr=state_save_write_file(machine,file);
+	mame_fclose(file);
+
+	if (staterr!=STATERR_NONE)
+	{
+		osd_rmfile(fullname);
+		Log("Snapshot: state save error %d, disabled\n",(int) staterr);
+		g_snapshot=0;
+		return TRUE;
+	}
+
+	strncpy(g_snap_path,fullname,sizeof(g_snap_path)-1);
+	strcpy(g_snap_display,g_display);
+	g_snap_valid=TRUE;
+	g_snap_owner=TRUE;
+
+	PrintAndLog("Snapshot saved      : %s\n\n",g_snap_name);
+	return TRUE;
+}
+
+//------------------------------
+// SnapTimeReset
+//------------------------------
+// Nach dem Laden eines Zustands laeuft die Emulatorzeit wieder ab dem Zeitpunkt der Sicherung
+// Gemerkte Zeitpunkte liegen sonst in der Zukunft (Frist nach Abbruch, Latenz Tastendruck)
+//
+static void SnapTimeReset(running_machine *machine)
+{
+	g_stop_time=timer_get_time(machine);
+	g_ev_key_time=timer_get_time(machine);
+	g_ev_key_pending=FALSE;
+}
+
+//------------------------------
+// SnapRestore
+//------------------------------
+// Zustand nach dem Start laden, Rueckgabe FALSE -> soft_reset
+//
+static int SnapRestore(running_machine *machine)
+{
+	file_error filerr;
+	state_save_error staterr;
+	mame_file *file;
+
+	if (!g_snap_valid || timer_count_anonymous(machine) > 0)
+		return FALSE;
+
+	filerr=mame_fopen(SEARCHPATH_STATE,g_snap_name,OPEN_FLAG_READ,&file);
+	if (filerr!=FILERR_NONE)
+	{
+		g_snap_valid=FALSE;
+		return FALSE;
+	}
+
+	staterr=state_save_read_file(machine,file);
+	mame_fclose(file);
+
+	if (staterr!=STATERR_NONE)													//Anderer Build bzw. Datei defekt
+	{
+		Log("Snapshot: state load error %d\n",(int) staterr);
+		g_snap_valid=FALSE;
+		return FALSE;
+	}
+
+	if (g_snap_display[0]!='\0')												//Anzeige wird vom ROM nicht neu geschrieben
+		strcpy(g_display,g_snap_display);
+
+	SnapTimeReset(machine);
+	return TRUE;
+}
+
+//------------------------------
+// SnapReady
+//------------------------------
+// Beim ersten DRIVER_READY: Zustand sichern, vorher Mindestdauer Bootvorgang abwarten
+//
+static int SnapReady(running_machine *machine)
+{
+	if (g_snapshot==0 || g_snap_valid)
+		return TRUE;
+
+	if (attotime_compare(timer_get_time(machine),ATTOTIME_IN_MSEC(SNAP_BOOT_MS)) < 0)
+		return FALSE;
+
+	return SnapCapture(machine);
+}
+
+//------------------------------
+// PlySnapClear
+//------------------------------
+// Nach new, setboard und Aenderung der Stufe gelten die gesicherten Halbzuege nicht mehr
+//
+static void PlySnapClear(int ply)
+{
+	if (ply==0)									//Neue Ausgangsstellung, Zugliste des ROMs wieder vollstaendig
+		g_injected=FALSE;
+
+	g_ply=ply;
+	g_ply_gen++;
+	g_ply_dirty=TRUE;
+}
+
+//------------------------------
+// PlyAdvance
+//------------------------------
+// Zug eingegeben bzw. Bestmove gesendet, Eintrag einer anderen Variante verwerfen
+//
+static void PlyAdvance(void)
+{
+	g_ply++;
+	if (g_plysnaps!=0)
+		g_ply_snap[g_ply % g_plysnaps].ply=-1;
+	g_ply_dirty=TRUE;
+}
+
+//------------------------------
+// PlySnapCapture
+//------------------------------
+// Im DRIVER_READY, sobald das Tastenfeld leer ist und das Display steht
+//
+static void PlySnapCapture(running_machine *machine)
+{
+	PLY_SNAP_T *snap;
+	file_error filerr;
+	state_save_error staterr;
+	mame_file *file;
+
+	if (g_plysnaps==0 || !g_ply_dirty)
+	{
+		g_ply_dirty=FALSE;
+		return;
+	}
+
+	if (!g_portIsReady || g_keypad_head!=g_keypad_tail || timer_count_anonymous(machine) > 0)
+	{
+		if (g_waitCnt > g_inputWait+PLY_SNAP_WAIT)
+		{
+			Log("Ply snapshot: module not ready, ply %d not saved\n",g_ply);
+			g_ply_dirty=FALSE;
+		}
+		return;
+	}
+
+	if (g_waitCnt <= g_inputWait)
+		return;
+
+	g_ply_dirty=FALSE;
+
+	snap=&g_ply_snap[g_ply % g_plysnaps];
+	sprintf(snap->name,PLY_FILE,machine->gamedrv->name,g_snap_tag,g_ply % g_plysnaps);
+
+	filerr=mame_fopen(SEARCHPATH_STATE,snap->name,OPEN_FLAG_WRITE|OPEN_FLAG_CREATE|OPEN_FLAG_CREATE_PATHS,&file);
+	if (filerr!=FILERR_NONE)
+	{
+		Log("Ply snapshot: cannot create %s, disabled\n",snap->name);
+		g_plysnaps=0;
+		return;
+	}
+
+	astring fullname(mame_file_full_name(file));
+
+	staterr=state_save_write_file(machine,file);
+	mame_fclose(file);
+
+	snap->ply=-1;
+	if (staterr!=STATERR_NONE)
+	{
+		osd_rmfile(fullname);
+		Log("Ply snapshot: state save error %d, disabled\n",(int) staterr);
+		g_plysnaps=0;
+		return;
+	}
+
+	snap->ply=g_ply;
+	snap->gen=g_ply_gen;
+	snap->force=xcmd_force_mode;
+	strcpy(snap->display,g_display);
+	strncpy(snap->path,fullname,sizeof(snap->path)-1);
+
+	Log("Ply snapshot: ply %d (%s)\n",g_ply,g_display);
+}
+
+//------------------------------
+// PlySnapRestore
+//------------------------------
+// undo/remove: Zustand nach Halbzug ply laden, Rueckgabe FALSE -> Tastenfolge wie bisher
+//
+static int PlySnapRestore(running_machine *machine, int ply)
+{
+	PLY_SNAP_T *snap;
+	file_error filerr;
+	state_save_error staterr;
+	mame_file *file;
+
+	if (g_plysnaps==0 || ply < 0 || g_ply-ply >= g_plysnaps)
+		return FALSE;
+
+	snap=&g_ply_snap[ply % g_plysnaps];
+	if (snap->ply!=ply || snap->gen!=g_ply_gen || snap->force!=xcmd_force_mode ||
+		timer_count_anonymous(machine) > 0)
+		return FALSE;
+
+	filerr=mame_fopen(SEARCHPATH_STATE,snap->name,OPEN_FLAG_READ,&file);
+	if (filerr!=FILERR_NONE)
+	{
+		snap->ply=-1;
+		return FALSE;
+	}
+
+	staterr=state_save_read_file(machine,file);
+	mame_fclose(file);
+
+	if (staterr!=STATERR_NONE)
+	{
+		Log("Ply snapshot: state load error %d\n",(int) staterr);
+		snap->ply=-1;
+		return FALSE;
+	}
+
+	strcpy(g_display,snap->display);
+	KeypadReset();
+	g_portIsReady=TRUE;
+	g_waitCnt=0;
+
+	g_ply=ply;
+	g_ply_dirty=FALSE;
+	SnapTimeReset(machine);
+
+	Log("Ply snapshot: ply %d restored (%s)\n",ply,g_display);
+	return TRUE;
+}
+
+//------------------------------
+// PlySnapExit
+//------------------------------
+static void PlySnapExit(void)
+{
+	int i;
+
+	for (i=0; i<PLY_SNAPS_MAX; i++)
+		if (g_ply_snap[i].path[0]!='\0')
+			osd_rmfile(g_ply_snap[i].path);
+}
+
+//------------------------------
+// PonderPrepare
+//------------------------------
+// Beim Senden des Bestmove: 2. Zug der PV ist die erwartete Antwort
+//
+static void PonderPrepare(const char *bestmove)
+{
+	char first[10];
+	char second[10];
+
+	g_ponder_pending=FALSE;
+
+	if (!g_ponder || !g_unlimited || xcmd_force_mode || g_plysnaps==0 || g_epd_mode)
+		return;
+
+	if (sscanf(xcmd_info.PV,"%9s %9s",first,second)!=2 ||
+		strncmp(first,bestmove,4) || strlen(second)!=4 || !TestMove(second))
+		return;
+
+	strcpy(g_ponder_move,second);
+	g_ponder_move[0]=tolower(second[0]);
+	g_ponder_move[2]=tolower(second[2]);
+	g_ponder_pending=TRUE;
+}
+
+//------------------------------
+// PonderStart
+//------------------------------
+// Im DRIVER_READY: Halbzug gesichert und noch keine Eingabe -> erwarteten Zug eingeben
+//
+static int PonderStart(running_machine *machine)
+{
+	if (!g_ponder_pending || g_ply_dirty)							//Warten bis PlySnapCapture fertig ist
+		return FALSE;
+
+	g_ponder_pending=FALSE;
+
+	if (g_input_taken || InputQueued(g_io) ||						//Gegner hat schon gezogen
+		g_plysnaps==0 || g_ply_snap[g_ply % g_plysnaps].ply!=g_ply)	//Halbzug nicht gesichert
+		return FALSE;
+
+	Log("Ponder: %s\n",g_ponder_move);
+
+	sprintf(g_cmd,"%ss",g_ponder_move);
+	g_cmd_inx=0;
+	g_cmd_len=strlen(g_cmd);
+	g_start_search=TRUE;
+	g_ponder_start=TRUE;
+
+	g_state=SENDCOMMAND;
+	return TRUE;
+}
+
+//------------------------------
+// PonderBestmove
+//------------------------------
+// Suche beim Pondern beendet: Display seit dem Loslassen von ENT geaendert und Zug im Display bzw. RAM
+// Der eingegebene Antwortzug selbst ist kein Bestmove
+//
+static int PonderBestmove(running_machine *machine)
+{
+	char symmove[10];
+	const char *bm;
+	int i;
+
+	if (!strcmp(g_display,g_ponder_display))
+		return FALSE;
+
+	if (SymReadBestmove(machine,symmove))
+		bm=symmove;
+	else if (TestMove(g_display))
+		bm=g_display;
+	else
+		return FALSE;
+
+	for (i=0; i<4; i++)
+		if (tolower(bm[i])!=g_ponder_move[i])
+			return TRUE;
+
+	Log("Ponder: search end ignored, %s is the ponder move\n",bm);
+	return FALSE;
+}
+
+//------------------------------
+// PonderHit
+//------------------------------
+// Gegner hat den erwarteten Zug gespielt: Suche laeuft weiter, ab jetzt mit Zeitkontrolle
+//
+static void PonderHit(running_machine *machine)
+{
+	InputProcessed();
+	PlyAdvance();
+	g_ponder_hits++;
+
+	Log("Ponder hit: %s%s\n",g_ponder_move,g_ponder_ended ? " (search ended)" : "");
+
+	if (g_ponder_ended && PonderBestmove(machine))					//Zug steht schon fest
+	{
+		g_state=BESTMOVE;
+		return;
+	}
+
+	g_state=SEARCHING;
+	g_break_search=FALSE;
+	g_search_ended=FALSE;
+	g_ev_end_valid=FALSE;
+	g_stop_pending=FALSE;
+	g_stop_move[0]='\0';
+
+	if (g_bridge.bm_reset!=NULL)
+		g_bridge.bm_reset();
+
+	TimeControl(machine,&g_tc);
+	if (!CycleBudgetStart(machine,&g_tc) && g_vclock)
+		VClockStart(machine,&g_tc);
+}
+
+//------------------------------
+// PonderMiss
+//------------------------------
+// Anderer Zug bzw. Befehl: Zustand nach dem eigenen Zug laden, dann die Eingabe normal auswerten
+// Rueckgabe FALSE -> spaeter nochmal (anonyme Timer)
+//
+static int PonderMiss(running_machine *machine)
+{
+	if (timer_count_anonymous(machine) > 0)
+		return FALSE;
+
+	g_ponder_misses++;
+
+	if (g_bridge.bm_reset!=NULL)
+		g_bridge.bm_reset();
+
+	if (PlySnapRestore(machine,g_ply))
+		Log("Ponder miss: %s expected, got %s\n",g_ponder_move,g_input);
+	else
+	{
+		PrintAndLog("Ponder miss: state of ply %d lost, reset\n",g_ply);
+		soft_reset(machine, NULL, 0);
+		KeypadReset();
+		g_portIsReady=TRUE;
+		PlySnapClear(0);
+	}
+
+	g_last_cmd='\0';
+	g_state=PARSEINPUT;
+	return TRUE;
+}
+
+//------------------------------
+// NewGame
+//------------------------------
+// new bzw. ucinewgame: Zustand nach dem Start laden, sonst soft_reset
+//
+static void NewGame(running_machine *machine)
+{
+	if (SnapRestore(machine))										//Zustand nach dem Start statt Bootvorgang
+		Log("Snapshot restored\n");
+	else
+	{
+		soft_reset(machine, NULL, 0);
+		Log("Softreset\n");	
+	}
+
+	KeypadReset();
+	g_portIsReady=TRUE;
+	PlySnapClear(0);
+
+	if ( strlen(xcmd_roll_diplay)!=0 )
+		g_rollDisplay=FALSE;
+
+	xcmd_force_mode=FALSE;
+	g_start_search=FALSE;
+	g_level9=FALSE;
+
+	clearTC();
+	g_cycles_fixed=0;
+	g_nps=0;
+
+	g_uci_fen[0]='\0';
+	g_uci_total=0;
+	g_uci_count=0;
+	g_uci_ponder=FALSE;
+}
+
+//------------------------------
+// UciWhiteToMove
+//------------------------------
+static int UciWhiteToMove(void)
+{
+	char side='w';
+
+	if (g_uci_fen[0]!='\0')
+		sscanf(g_uci_fen,"%*s %c",&side);
+
+	return (side=='b') == (g_uci_total & 1);
+}
+
+//------------------------------
+// UciMoveKeys
+//------------------------------
+// Tastenfolge fuer einen Zug wie beim xboard usermove
+//
+static void UciMoveKeys(char *cmd, char *move)
+{
+	strncat(cmd,move,4);
+
+	if (isPromoInput(move))
+	{
+		strcat(cmd,"s");
+		switch (tolower(move[4]))
+		{
+		case 'q': 
+			strcat(cmd,xcmd_promo_q);
+			break;
+		case 'r': 
+			strcat(cmd,xcmd_promo_r);
+			break;
+		case 'b': 
+			strcat(cmd,xcmd_promo_b);
+			break;
+		case 'n': 
+			strcat(cmd,xcmd_promo_n);
+			break;
+		default:
+			break;
+		}
+	}
+	strcat(cmd,"s");
+}
+
+//------------------------------
+// UciPosition
+//------------------------------
+// Nur die Zuege eingeben, die das Modul noch nicht kennt. Andere Variante -> gesicherter Halbzug,
+// sonst neue Partie. Ohne inject_move werden die Zuege erst mit go ueber die Tasten eingegeben
+//
+static void UciPosition(running_machine *machine, char *param)
+{
+	char fen[100];
+	char moves[UCI_MOVES_MAX][6];
+	char *tok;
+	int n=0;
+	int k=0;
+
+	fen[0]='\0';
+	tok=StrTok(NULL, " ",&g_cmd_tok);
+
+	if (param!=NULL && !strcmp(param,"fen"))
+	{
+		for (; tok!=NULL && strcmp(tok,"moves"); tok=StrTok(NULL, " ",&g_cmd_tok))
+		{
+			if (fen[0]!='\0')
+				strcat(fen," ");
+			strncat(fen,tok,sizeof(fen)-strlen(fen)-2);
+		}
+	}
+
+	if (tok!=NULL && !strcmp(tok,"moves"))
+	{
+		while (n < UCI_MOVES_MAX && (tok=StrTok(NULL, " ",&g_cmd_tok))!=NULL)
+		{
+			if (!TestMove(tok))
+				break;
+			strncpy(moves[n],tok,5);
+			moves[n][5]='\0';
+			n++;
+		}
+	}
+
+	if (!strcmp(fen,g_uci_fen))
+		while (k < g_uci_count && k < n && !strcmp(moves[k],g_uci_moves[k]))
+			k++;
+
+	if (strcmp(fen,g_uci_fen) || (k < g_uci_count && !PlySnapRestore(machine,k)))
+	{
+		Log("UCI position: new game (%d moves)\n",n);
+
+		NewGame(machine);
+		k=0;
+
+		if (fen[0]!='\0' && SetBoardDirect(machine,fen))			//Stellung direkt ins RAM
+			Log("Board set in RAM: %s\n",fen);
+		else if (fen[0]!='\0')										//Stellung ueber Tasten, danach force
+		{
+			strcpy(g_cmd,xcmd_force);
+			xcmd_force_mode=TRUE;
+			if (!CmdFromFEN(machine,fen,&g_cmd[strlen(g_cmd)],TRUE))
+			{
+				PrintAndLog("UCI position: invalid FEN %s\n",fen);
+				g_cmd[0]='\0';
+				xcmd_force_mode=FALSE;
+				fen[0]='\0';
+			}
+		}
+		PlySnapClear(0);
+		strcpy(g_uci_fen,fen);
+	}
+	else if (k < g_uci_count)
+		Log("UCI position: back to ply %d\n",k);
+
+	g_uci_count=k;
+	memcpy(g_uci_moves,moves,sizeof(moves[0])*n);
+	g_uci_total=n;
+
+	if (g_inject && g_bridge.inject_move!=NULL && g_cmd[0]=='\0')	//Zuege direkt ins RAM schreiben
+	{
+		while (g_uci_count < g_uci_total &&
+			   g_bridge.inject_move(machine,g_uci_moves[g_uci_count],xcmd_force_mode))
+		{
+			g_uci_count++;
+			PlyAdvance();
+			g_injected=TRUE;
+		}
+	}
+
+	Log("UCI position: %d of %d moves in module\n",g_uci_count,g_uci_total);
+}
+
+//------------------------------
+// UciGo
+//------------------------------
+// Zeitvorgaben nach g_tc (nur bei mmunlimited), restliche Zuege eingeben, Suche starten
+//
+static void UciGo(running_machine *machine, char *param)
+{
+	UINT32 wtime=0,btime=0,winc=0,binc=0,movestogo=0,movetime=0;
+	int infinite=FALSE;
+	int white;
+	char *value;
+
+	g_uci_ponder=FALSE;
+
+	for (; param!=NULL; param=StrTok(NULL, " ",&g_cmd_tok))
+	{
+		if (!strcmp(param,"infinite"))
+			infinite=TRUE;
+		else if (!strcmp(param,"ponder"))
+			g_uci_ponder=TRUE;
+		else if ((value=StrTok(NULL, " ",&g_cmd_tok))==NULL)
+			break;
+		else if (!strcmp(param,"wtime"))
+			wtime=atoi(value);
+		else if (!strcmp(param,"btime"))
+			btime=atoi(value);
+		else if (!strcmp(param,"winc"))
+			winc=atoi(value);
+		else if (!strcmp(param,"binc"))
+			binc=atoi(value);
+		else if (!strcmp(param,"movestogo"))
+			movestogo=atoi(value);
+		else if (!strcmp(param,"movetime"))
+			movetime=atoi(value);
+		else if (!strcmp(param,"cycles"))						//Wie go cycles N beim xboard
+			g_cycles_fixed=strtoull(value,NULL,10);
+		else
+			Log("UCI go: %s %s not supported\n",param,value);	//depth, nodes, mate, searchmoves
+	}
+
+	g_cmd[0]='\0';
+
+	if (g_unlimited)
+	{
+		white=UciWhiteToMove();
+
+		clearTC();
+		g_tc.side=white ? WHITE : BLACK;
+		g_tc.wtime=wtime;
+		g_tc.btime=btime;
+		g_tc.winc=winc;
+		g_tc.binc=binc;
+		g_tc.time=white ? wtime : btime;
+		g_tc.otim=white ? btime : wtime;
+		g_tc.inc=white ? winc : binc;
+		g_tc.movestogo=movestogo;
+		g_tc.movestogo_start=movestogo;
+		g_tc.fixmovetime=infinite ? 0xffffffff : movetime;
+
+		if (g_uci_ponder)										//Zeitkontrolle erst ab ponderhit
+		{
+			g_uci_tc=g_tc;
+			g_tc.fixmovetime=0xffffffff;
+		}
+
+		if (!g_level9)											//LEV 9 = unendlich falls noch nicht passiert
+		{
+			if (xcmd_force_mode)
+				strcat(g_cmd,"r");
+			strcat(g_cmd,xcmd_lev9);
+			if (xcmd_force_mode)
+				strcat(g_cmd,"m");
+			g_level9=TRUE;
+		}
+	}
+	else if (wtime || btime || movetime || infinite || g_uci_ponder)
+		Log("UCI go: time control by module level (nommunlimited)\n");
+
+	if ( (strlen(xcmd_roll_diplay)!=0) && !g_rollDisplay)		//Infozeilen wie nach post
+	{
+		strcat(g_cmd,xcmd_roll_diplay);
+		g_rollDisplay=TRUE;
+	}
+
+	if (g_uci_total-g_uci_count==1 && !xcmd_force_mode)		//Zug des Gegners startet die Suche wie beim usermove
+	{
+		UciMoveKeys(g_cmd,g_uci_moves[g_uci_count++]);
+		PlyAdvance();
+	}
+	else
+	{
+		if (g_uci_count < g_uci_total && !xcmd_force_mode)		//Mehrere Zuege ohne Suche eingeben
+		{
+			strcat(g_cmd,xcmd_force);
+			xcmd_force_mode=TRUE;
+		}
+
+		while (g_uci_count < g_uci_total)
+		{
+			UciMoveKeys(g_cmd,g_uci_moves[g_uci_count++]);
+			PlyAdvance();
+		}
+
+		if (xcmd_force_mode)
+		{
+			xcmd_force_mode=FALSE;
+			strcat(g_cmd,"r");
+		}
+		strcat(g_cmd,"s");
+	}
+
+	g_start_search=TRUE;
+}
+
+//------------------------------
+// UciInfo
 //------------------------------
-static void LogProfiler(running_machine *machine)
+// Infozeile im UCI Format: Bewertung 0.85 -> cp 85, Rechenzeit mm:ss bzw. Centisekunden -> ms
+//
+static void UciInfo(XCMD_INFO_T *info)
 {
-	astring profilertext;
+	char buffer[100];
+	int score,min,sec,ms;
+	double pawns;
 
-	if (g_waitCnt % 10 == 0)												 	
-	{																	 
-		profiler_get_text(machine, profilertext);
+	if (strchr(info->score,'.')!=NULL)
+	{
+		pawns=atof(info->score)*100;
+		score=(int) (pawns < 0 ? pawns-0.5 : pawns+0.5);
+	}
+	else
+		score=atoi(info->score);
 
-		if (astring_len(&profilertext) > 0)								 
-			Log("Profiler: \n\n%s\n",astring_c(&profilertext));			 
+	if (sscanf(info->time,"%d:%d",&min,&sec)==2)
+		ms=(min*60+sec)*1000;
+	else
+		ms=atoi(info->time)*10;
 
-		astring_free(&profilertext);										 
-	}																	 
+	sprintf(buffer,"info depth %d score cp %d time %d nodes %s",atoi(info->ply),score,ms,info->nodes);
 
+	if (info->PV[0]!='\0' && strchr(info->PV,'_')==NULL)
+	{
+		strcat(buffer," pv ");
+		strcat(buffer,info->PV);
+	}
+	strcat(buffer,"\n");
+
+	SendToGUI(buffer);
 }
-//------------------------------
-// PrintLevel                                         
-//------------------------------
-static void PrintLevel()
-{
-	PrintAndLog("Supported Levels:\n\n");
-	PrintAndLog("Level 0: 3   seconds/move   -> st 3\n");
-	PrintAndLog("Level 1: 5   seconds/move   -> st 5\n");
-	PrintAndLog("Level 2: 10  seconds/move   -> st 10\n");
-	PrintAndLog("Level 3: 20  seconds/move   -> st 20\n");
-	PrintAndLog("Level 4: 60  seconds/move   -> st 60\n");
-	PrintAndLog("Level 5: 120 seconds/move   -> st 120\n");
-	PrintAndLog("Level 6: 40 move in 2 hours -> level 40 120 0\n\n");
-}
+
 //------------------------------
 // ProcessDRIVER_START                                          
 //------------------------------
@@ -1642,10 +5939,26 @@ static void ProcessDRIVER_START(running_machine *machine)
 	{
 		g_waitCnt=0;	
 		g_start_time_sc=GetTime();
-	}else if (g_waitCnt>=g_per_wait)
+
+		if (g_snapshot==2)																//Zustand vom letzten Start -> kein Bootvorgang
+		{
+			g_snap_valid=TRUE;
+			if (SnapRestore(machine))
+				PrintAndLog("Snapshot loaded     : %s\n\n",g_snap_name);
+		}
+
+		if (g_per_wait!=0 && (g_time_per_sec=CalibLoad(machine->gamedrv->name))!=0)	//Messung aus dem Cache
+		{
+			g_calib_cached=TRUE;
+			g_per_wait=0;
+		}
+	}else if (g_waitCnt>=g_per_wait && SnapReady(machine))
 	{
 		g_end_time_sc=GetTime();
-		g_time_per_sec=(g_end_time_sc-g_start_time_sc)/10;
+		if (g_calib_cached)
+			PrintAndLog("Calibration cache   : %s\n",g_calib_key);
+		else
+			g_time_per_sec=(g_end_time_sc-g_start_time_sc)/10;
 		g_time_corr=(float) g_time_per_sec/TC_DELAY_REF;
 
 		PrintAndLog("Emulator org. clock : %d\n",g_org_clock);
@@ -1660,8 +5973,12 @@ static void ProcessDRIVER_START(running_machine *machine)
 			{
 				g_time_corr=(float) g_time_per_sec/TC_DELAY_REF;
 
+				g_calib_tc_delay= g_tc_delay;
 				g_tc_delay		= g_tc_delay * g_time_corr;
 
+				if (!g_calib_cached)
+					CalibSave(machine->gamedrv->name,g_time_per_sec);
+
 				PrintAndLog("Time in ms for 1 sec: %d\n",g_time_per_sec);
 				PrintAndLog("Speed factor time   : %2.2f\n\n",(float)1000/g_time_per_sec);
 
@@ -1681,6 +5998,8 @@ static void ProcessDRIVER_START(running_machine *machine)
 			PrintLevel();
 		}
 
+		OvhLoad(machine->gamedrv->name);
+
 
 
 		g_state=DRIVER_READY;
@@ -1692,33 +6011,54 @@ static void ProcessDRIVER_START(running_machine *machine)
 //------------------------------
 static void ProcessSEARCHING(running_machine *machine)
 {
-	EMU_KEY_T *keycode;
-
 	int InfoData=TRUE;
 	char valid[] = " -0123456789AbCdEFGH";
 	char valid_movecheck[] = "AbCdEFGH";
 
 
+	CalibCheck(machine);												//Kalibrierung aus dem Cache pruefen
+
+	if (StopDeadline(machine))											//Frist nach Abbruch abgelaufen -> Zug senden
+		return;
+
 	if (g_InputCheck <= 0)												//Eingabeprfung whrend der Suche
 	{
-		g_ret=WaitInputAvailable(WaitTime);
+		g_ret=WaitInputAvailable(g_poll_wait);						//Nicht blockieren, die Suche laeuft weiter
 		g_InputCheck=g_InputCheckStart;
 
-		if (!g_break_search)
+		if (g_ret && !g_break_search)
 		{
-			if (!strcmp(g_input,"?") || !strcmp(g_input,"exit"))		//Sonderfall Suchabbruch durch ?,quit
+			if (!strcmp(g_input,"?") || !strcmp(g_input,"exit") ||		//Sonderfall Suchabbruch durch ?,quit
+				!strcmp(g_input,"stop"))								//bzw. UCI stop
 			{															// Falls ? gesendet wird
 				Log("GUI    Input : %s ->Search break\n",g_input);		
 
-				keycode=GetKeycode(g_keys,'s');							// SEARCHING , dann durch drcken 
-				input_port_set(machine,keycode->name,keycode->data);	// der <Enter> taste die Suche abbrechen
-
-				g_break_search=TRUE;									//Flag Suchabbruch 
+				g_uci_ponder=FALSE;
+				StopSearch(machine);									//Stopflag bzw. Taste ENT
 
 				InputProcessed();
 
 			}else if (!strcmp(g_input,"."))								//Nicht auswerten
 				InputProcessed();
+			else if (!strcmp(g_input,"isready"))
+			{
+				SendToGUI((char *)"readyok\n");
+				InputProcessed();
+			}
+			else if (!strcmp(g_input,"ponderhit"))						//Suche laeuft weiter, ab jetzt mit Zeitkontrolle
+			{
+				Log("GUI    Input : %s\n",g_input);
+
+				if (g_uci_ponder)
+				{
+					g_uci_ponder=FALSE;
+					g_tc=g_uci_tc;
+					TimeControl(machine,&g_tc);
+					if (!CycleBudgetStart(machine,&g_tc) && g_vclock)
+						VClockStart(machine,&g_tc);
+				}
+				InputProcessed();
+			}
 			else if (!strcmp(g_input,"quit"))
 			{
 				Log("GUI    Input : %s ->Search quit\n",g_input);
@@ -1727,6 +6067,26 @@ static void ProcessSEARCHING(running_machine *machine)
 				g_state=DRIVER_READY;
 				return;
 			}
+			else if (!strncmp(g_input,"time ",5))						//Harmlose Zeilen sofort auswerten
+			{
+				g_tc.time=atoi(&g_input[5])*10;
+				InputProcessed();
+			}
+			else if (!strncmp(g_input,"otim ",5))
+			{
+				g_tc.otim=atoi(&g_input[5])*10;
+				InputProcessed();
+			}
+			else if (!strcmp(g_input,"nopost") ||
+					 (!strcmp(g_input,"post") && (g_rollDisplay || strlen(xcmd_roll_diplay)==0)))
+				InputProcessed();
+			else if (InputStopQueued())									//z.B. ping vor ? -> Zeile bleibt fuer nach der Suche
+			{
+				Log("GUI    Input : %s ->Search break (queued)\n",g_input);
+
+				g_uci_ponder=FALSE;
+				StopSearch(machine);
+			}
 			//else if (g_input[0]!='\0')
 			//	InputProcessed();
 
@@ -1737,17 +6097,15 @@ static void ProcessSEARCHING(running_machine *machine)
 
 	if (g_unlimited)
 	{
-		if (g_TimeCheck <= 0 && !g_break_search)	
+		if (g_TimeCheck <= 0 && !g_break_search && !g_vclock && !g_cycle_budget)	//VClockExpired bzw. CycleBudgetExpired
 		{
 			g_TimeCheck=TIMECHECK;
-			if (TimeOver(&g_tc) )										//Zeit abgelaufen
+			if (TimeOver(machine,&g_tc) )										//Zeit abgelaufen
 			{
 				Log(" ->Time Over\n");		 
+				OvhSearchEnd();
 
-				keycode=GetKeycode(g_keys,'s');
-				input_port_set(machine,keycode->name,keycode->data);
-
-				g_break_search=TRUE;									//Flag Suchabbruch 
+				StopSearch(machine);									//Flag Suchabbruch 
 
 			}
 		}//End h_TimeCheck
@@ -1784,6 +6142,18 @@ static void ProcessSEARCHING(running_machine *machine)
 
 		 strcpy(g_save_info,g_display);
 
+// Infozeile direkt aus dem RAM (Symboltabelle), dann keine Auswertung der rollierenden Anzeige
+//
+		 if (SymReadInfo(machine,&xcmd_info))
+		 {
+			sprintf(xcmd_info_string,"%s %s %s %s %s\n",xcmd_info.ply,xcmd_info.score,xcmd_info.time,xcmd_info.nodes,xcmd_info.PV);
+			if (g_uci_mode)
+				UciInfo(&xcmd_info);
+			else
+				SendToGUI(xcmd_info_string);
+			return;
+		 }
+
 
 // Start der rolliernden Anzeige herausfinden
 //
@@ -1942,7 +6312,9 @@ static void ProcessSEARCHING(running_machine *machine)
 				xcmd_info_string[strlen(xcmd_info_string)]='\n';
 				xcmd_info_string[1+strlen(xcmd_info_string)]='\0';
 
-				if (g_send_info)
+				if (g_send_info && g_uci_mode)
+					UciInfo(&xcmd_info);
+				else if (g_send_info)
 					SendToGUI(xcmd_info_string);
 
 			 }//End if g_info_index
@@ -1981,7 +6353,10 @@ static void ProcessSEARCHING(running_machine *machine)
 				xcmd_info_string[strlen(xcmd_info_string)]='\n';
 				xcmd_info_string[1+strlen(xcmd_info_string)]='\0';
 
-				SendToGUI(xcmd_info_string);
+				if (g_uci_mode)
+					UciInfo(&xcmd_info);
+				else
+					SendToGUI(xcmd_info_string);
 
 				g_info_index=0;
 			}else if (strcmp(g_display,"0000") && g_emu==EMU_MM)		//Zhler beim 0000 nicht hochzhlen
@@ -1993,23 +6368,76 @@ static void ProcessSEARCHING(running_machine *machine)
 
 }
 
+//------------------------------
+// ProcessPONDERING                                           
+//------------------------------
+// Das ROM rechnet auf Zeit des Gegners, keine Ausgabe an die GUI
+//
+static void ProcessPONDERING(running_machine *machine)
+{
+	char xboardstring[40];
+
+	if (g_ponder_display[0]=='\0' && g_portIsReady)					//ENT losgelassen, Suche laeuft
+		strcpy(g_ponder_display,g_display);
+
+	if (!g_input_taken)												//Sonst wartet PonderMiss auf anonyme Timer
+	{
+		if (g_InputCheck-- > 0)
+			return;
+		g_InputCheck=g_InputCheckStart;
+
+		if (!WaitInputAvailable(g_poll_wait))
+			return;
+	}
+
+	if (!strncmp(g_input,"time ",5))
+	{
+		g_tc.time=atoi(&g_input[5])*10;
+		InputProcessed();
+	}
+	else if (!strncmp(g_input,"otim ",5))
+	{
+		g_tc.otim=atoi(&g_input[5])*10;
+		InputProcessed();
+	}
+	else if (!strcmp(g_input,".") || !strcmp(g_input,"?") || !strcmp(g_input,"hard") ||
+			 !strcmp(g_input,"post") || !strcmp(g_input,"nopost"))
+		InputProcessed();
+	else if (!strncmp(g_input,"ping ",5))
+	{
+		sprintf(xboardstring,"pong %.30s\n",&g_input[5]);
+		SendToGUI(xboardstring);
+		InputProcessed();
+	}
+	else if (!strcmp(g_input,g_ponder_move))
+		PonderHit(machine);
+	else
+		PonderMiss(machine);
+}
+
 //------------------------------
 // ProcessDRIVER_READY                                           
 //------------------------------
-static void ProcessDRIVER_READY(void)
+static void ProcessDRIVER_READY(running_machine *machine)
 {
 	int InputWaitTime;
 
+	PlySnapCapture(machine);		//Modul wartet auf Eingabe -> Zustand des Halbzugs sichern
+
+	if (PonderStart(machine))		//Erwartete Antwort auf Zeit des Gegners rechnen
+		return;
+
 	if (g_error)					//Abfangen von Fehlersituationen -> Vermeidet dass keine Eingabe mehr mglich ist
 	{
 		InputProcessed();
+		SearchTimersReset();		//Suche ohne Bestmove beendet
 		g_error=FALSE;
 	}
 
-	if (g_unlimited)				//Bei umlimited die Emulation stoppen wenn auf Eingabe gewarted wird
+	if (g_unlimited && !g_ply_dirty)	//Bei umlimited die Emulation stoppen wenn auf Eingabe gewarted wird
 		InputWaitTime=INFINITE;		//Bei Orginalgeschwindigkeit nicht stoppen, wegen Pondern
-	else
-		InputWaitTime=WaitTime;
+	else							//bzw. solange der Halbzug noch gesichert wird
+		InputWaitTime=g_poll_wait;
 
 	if (g_InputCheck <= 0)
 	{
@@ -2033,8 +6461,12 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	Log("GUI    Input : %s\n",g_input);
 
-	cmd1=strtok(g_input, " ");			//1. Teil des Strings
-	nextcmd=strtok(NULL, " ");			//2. Teil des Strings
+	cmd1=StrTok(g_input, " ",&g_cmd_tok);			//1. Teil des Strings
+	nextcmd=StrTok(NULL, " ",&g_cmd_tok);			//2. Teil des Strings
+
+	if (cmd1!=NULL &&								//Zeitverbrauch Zugein/ausgabe ab dem Zug der GUI
+		((TestMove(cmd1) && !xcmd_force_mode) || (g_uci_mode && !strcmp(cmd1,"position"))))
+		g_ovh_t_input=GetTime();
 
 	if (!g_unlimited)										//Beschleunigung der Eingabe bei nommunlimited
 	{														//Auch fr mmunlimited anwendbar ? -> pruefen
@@ -2059,7 +6491,7 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"get_clock") )
 	{
-		printf("cpu_get_clock:     %d\n",cpu_get_clock(machine->firstcpu) );
+		PrintAndLog("cpu_get_clock:     %d\n",cpu_get_clock(machine->firstcpu) );
 		InputProcessed();
 		g_state=DRIVER_READY;
 		return;
@@ -2076,7 +6508,7 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"get_clockscale") )
 	{
-		printf("cpu_get_clockscale:     %f\n",cpu_get_clockscale(machine->firstcpu) );
+		PrintAndLog("cpu_get_clockscale:     %f\n",cpu_get_clockscale(machine->firstcpu) );
 		InputProcessed();
 		g_state=DRIVER_READY;
 		return;
@@ -2135,25 +6567,52 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"new") )
 	{
+		NewGame(machine);
+		
+		InputProcessed();
+		g_state=DRIVER_READY;
+		return;
+		
+	}
 
-		soft_reset(machine, NULL, 0);
-		Log("Softreset\n");	
+// UCI Befehle
+//
 
-		if ( strlen(xcmd_roll_diplay)!=0 )
-			g_rollDisplay=FALSE;
+	else if (!strcmp(cmd1,"uci") )
+	{
+		g_uci_mode = TRUE;
+		g_xboard_mode = TRUE;									//Displayanzeige nur ins Logfile
 
-		xcmd_force_mode=FALSE;
-		g_start_search=FALSE;
-		g_level9=FALSE;
+		sprintf(uci_string_send,uci_string,g_myname);
+		SendToGUI(uci_string_send);
+		InputProcessed();
+		g_state=DRIVER_READY;
+		return;
+	}
+
+	else if (!strcmp(cmd1,"isready") )
+	{
+		SendToGUI((char *)"readyok\n");
+		InputProcessed();
+		g_state=DRIVER_READY;
+		return;
+	}
+
+	else if (!strcmp(cmd1,"ucinewgame") )
+	{
+		NewGame(machine);
 
-		clearTC();
-		
 		InputProcessed();
 		g_state=DRIVER_READY;
 		return;
-		
 	}
 
+	else if (!strcmp(cmd1,"position") && g_uci_mode )
+		UciPosition(machine,nextcmd);
+
+	else if (!strcmp(cmd1,"go") && g_uci_mode )
+		UciGo(machine,nextcmd);
+
 	else if (!strcmp(cmd1,"post") )
 	{
 //		if (g_emu==EMU_MM)
@@ -2168,6 +6627,7 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"easy") )
 	{
+		g_ponder=FALSE;
 		if (g_unlimited && !g_level9)		//LEV 9 = unendlich falls noch nicht passiert
 		{
 			strcpy(g_cmd,xcmd_lev9); 							
@@ -2177,6 +6637,7 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"hard") )
 	{
+		g_ponder=g_ponder_option;
 		if (g_unlimited && !g_level9)		//LEV 9 = unendlich falls noch nicht passiert
 		{
 			strcpy(g_cmd,xcmd_lev9); 							
@@ -2200,26 +6661,40 @@ static void ProcessPARSEINPUT(running_machine *machine)
 		xboardfen[0]='\0';
 		if (nextcmd!=NULL)
 			strcat(xboardfen,nextcmd);
-		while ( (nextcmd=strtok(NULL, " ")) != NULL )
+		while ( (nextcmd=StrTok(NULL, " ",&g_cmd_tok)) != NULL )
 		{
 			strcat(xboardfen," ");
 			strcat(xboardfen,nextcmd);
 		}
 
-		if (!CmdFromFEN(machine,&xboardfen[0],&g_cmd[0],xcmd_force_mode))
+		if (SetBoardDirect(machine,xboardfen))				//Stellung direkt ins RAM
+		{
+			Log("Board set in RAM: %s\n",xboardfen);
+		}
+		else if (!CmdFromFEN(machine,&xboardfen[0],&g_cmd[0],xcmd_force_mode))
 		{
 			InputProcessed();
 			g_state=DRIVER_READY;
 			return;
 		}
+		PlySnapClear(0);
 	}
 
+	else if (!strcmp(cmd1,"mmwaits") )						//Handshake Wartezeiten (-mmtune)
+		HsCommand(machine,nextcmd);
+
 	else if(!strcmp(cmd1,"time"))
 		g_tc.time=atoi(nextcmd)*10;
 
 	else if(!strcmp(cmd1,"otim"))
 		g_tc.otim=atoi(nextcmd)*10; 
 
+	else if(!strcmp(cmd1,"nps") && nextcmd!=NULL)				//Zyklen pro Sekunde Zugzeit statt Zeit
+		g_nps=strtoul(nextcmd,NULL,10);
+
+	else if(!strcmp(cmd1,"cycles") && nextcmd!=NULL)			//Feste Anzahl Zyklen pro Zug
+		g_cycles_fixed=strtoull(nextcmd,NULL,10);
+
 
 	else if (!strcmp(cmd1,"st") )
 	{
@@ -2282,10 +6757,10 @@ static void ProcessPARSEINPUT(running_machine *machine)
 			g_tc.movestogo=atoi(nextcmd);
 			g_tc.movestogo_start=g_tc.movestogo;
 
-			nextcmd=strtok(NULL, " ");
+			nextcmd=StrTok(NULL, " ",&g_cmd_tok);
 			if (nextcmd!=NULL)									//Nicht ausgewertet wird durch time/otim gebildet
 			{
-				nextcmd=strtok(NULL, " ");
+				nextcmd=StrTok(NULL, " ",&g_cmd_tok);
 				if (nextcmd!=NULL)
 				{
 					g_tc.winc=atoi(nextcmd)*1000;				// Nicht genutzt
@@ -2298,14 +6773,14 @@ static void ProcessPARSEINPUT(running_machine *machine)
 		{
 			if (!strcmp(nextcmd,"40") )
 			{
-				nextcmd=strtok(NULL, " ");
+				nextcmd=StrTok(NULL, " ",&g_cmd_tok);
 				if (nextcmd!=NULL && !strcmp(nextcmd,"120") )
 				{
 					strcpy(g_cmd,xcmd_level40_2);				//LEV 6 40 Zge in 2 Stunden
 				}
 			}else if (!strcmp(nextcmd,"0") )					//z.B. level 0 5 0 = 5 Minuten pro Partie
 			{
-				nextcmd=strtok(NULL, " ");
+				nextcmd=StrTok(NULL, " ",&g_cmd_tok);
 
 				if (nextcmd!=NULL && !strcmp(nextcmd,"9999") )
 				{
@@ -2381,12 +6856,26 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"undo") )
 	{
-		strcpy(g_cmd,xcmd_undo);
+		if (!PlySnapRestore(machine,g_ply-1))					//Gesicherter Zustand, sonst Tastenfolge
+		{
+			if (g_injected)										//Tasten nehmen nur Zuege der Zugliste zurueck
+			{
+				SendToGUI((char *)"Error (no state saved after -mminject): undo\n");
+				InputProcessed();
+				g_state=DRIVER_READY;
+				return;
+			}
 
-		if(!xcmd_force_mode)
 			strcpy(g_cmd,xcmd_undo);
-		else
-			strcpy(g_cmd,"9");
+
+			if(!xcmd_force_mode)
+				strcpy(g_cmd,xcmd_undo);
+			else
+				strcpy(g_cmd,"9");
+
+			if (g_ply > 0)
+				g_ply--;
+		}
 
 		if (g_tc.movestogo > 0)
 			g_tc.movestogo--;
@@ -2395,12 +6884,25 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"remove") )
 	{
-		strcpy(g_cmd,xcmd_remove);
+		if (!PlySnapRestore(machine,g_ply-2))					//Gesicherter Zustand, sonst Tastenfolge
+		{
+			if (g_injected)										//Tasten nehmen nur Zuege der Zugliste zurueck
+			{
+				SendToGUI((char *)"Error (no state saved after -mminject): remove\n");
+				InputProcessed();
+				g_state=DRIVER_READY;
+				return;
+			}
 
-		if(!xcmd_force_mode)
-			strcpy(g_cmd,xcmd_remove);		
-		else
-			strcpy(g_cmd,&xcmd_remove[1]);	
+			strcpy(g_cmd,xcmd_remove);
+
+			if(!xcmd_force_mode)
+				strcpy(g_cmd,xcmd_remove);		
+			else
+				strcpy(g_cmd,&xcmd_remove[1]);	
+
+			g_ply=MAX(g_ply-2,0);
+		}
 
 		if (g_tc.movestogo > 1)
 			g_tc.movestogo=g_tc.movestogo-2;
@@ -2411,6 +6913,9 @@ static void ProcessPARSEINPUT(running_machine *machine)
 
 	else if (!strcmp(cmd1,"go") )
 	{
+		if (nextcmd!=NULL && !strcmp(nextcmd,"cycles") && (nextcmd=StrTok(NULL," ",&g_cmd_tok))!=NULL)	//go cycles N
+			g_cycles_fixed=strtoull(nextcmd,NULL,10);
+
 		strcpy(g_cmd,"s");
 		g_start_search=TRUE;
 
@@ -2432,12 +6937,29 @@ static void ProcessPARSEINPUT(running_machine *machine)
 		
 	}
 
+	else if (TestMove(cmd1) &&								// Zug direkt ins RAM schreiben
+			 g_inject			&&
+			 g_bridge.inject_move!=NULL &&
+			 g_bridge.inject_move(machine,cmd1,xcmd_force_mode) )
+	{
+		Log("Move injected: %s xcmd_force_mode: %d\n",cmd1,xcmd_force_mode);
+		PlyAdvance();
+		g_injected=TRUE;
+
+		if (!xcmd_force_mode)								//Nur noch ENT -> Suche starten
+		{
+			strcpy(g_cmd,"s");
+			g_start_search=TRUE;
+		}
+	}
+
 	else if (TestMove(cmd1))	// Prfen ob das ein Zug war
 	{
 		strncpy(g_cmd,cmd1,4);
 		g_cmd[4]='\0';
 
 		Log("xcmd_force_mode: %d\n",xcmd_force_mode);
+		PlyAdvance();
 		
 		if (isPromoInput(cmd1))			//Promozug
 		{
@@ -2469,6 +6991,15 @@ static void ProcessPARSEINPUT(running_machine *machine)
 	
 	Log("g_cmd: %s\n",g_cmd);
 
+	if (g_cmd[0]!=0)										//Tasten -> Zustand des Halbzugs neu sichern
+	{
+		if (TestMove(cmd1) || !strcmp(cmd1,"undo") || !strcmp(cmd1,"remove") ||
+			!strcmp(cmd1,"go") || !strcmp(cmd1,"force") || !strcmp(cmd1,"position"))
+			g_ply_dirty=TRUE;
+		else
+			PlySnapClear(g_ply);							//Stufe, Stellung o.ae. geaendert
+	}
+
 // Befehlszeile gefunden, dann ausfhren
 //
 	if (g_cmd[0]!=0)
@@ -2498,29 +7029,64 @@ static void ProcessSENDCOMMAND(running_machine *machine)
 
 	if (g_cmd_inx >= g_cmd_len)		//Ende Befehlsstring
 	{		
+		if (g_keyscans && !g_portIsReady)		//Tastenfeld noch nicht leer
+			return;
+
 		g_state=DRIVER_READY;
-		InputProcessed();
+		if (g_cmd_internal)						//Eingabezeile (falls vorhanden) gehoert nicht zu dieser Folge
+			g_cmd_internal=FALSE;
+		else
+			InputProcessed();
 		return;
 	}
 	
-	if  (g_portIsReady && 
+	if  (g_keyscans ? g_keypad_head - g_keypad_tail < KEYPAD_QUEUE_SIZE :		//Platz im Tastenfeld
+		 g_portIsReady && 
 		 g_waitCnt > g_inputWait )				//Wartezeit
 
 	{
 
 		keycode=GetKeycode(g_keys,g_cmd[g_cmd_inx]);
-    	input_port_set(machine,keycode->name,keycode->data);
+    	KeypadPress(machine,keycode);
+
+		g_ev_key_pending=TRUE;							//Latenz bis zur Displayaenderung
+		g_ev_key_time=timer_get_time(machine);
 
 //		input_port_write(machine, keycode->name, keycode->data, 0xff);
 
 
-		if (g_start_search==TRUE && g_cmd_inx==(g_cmd_len-1 ))
+		if (g_start_search==TRUE && g_cmd_inx==(g_cmd_len-1 ) && g_ponder_start)
+		{
+			g_state=PONDERING;							//Ohne Zeitkontrolle bis zum Zug des Gegners
+			g_start_search=FALSE;
+			g_ponder_start=FALSE;
+			g_ponder_ended=FALSE;
+			g_ponder_display[0]='\0';
+
+			if (g_bridge.bm_reset!=NULL)
+				g_bridge.bm_reset();
+
+			SearchTimersReset();
+		}
+		else if (g_start_search==TRUE && g_cmd_inx==(g_cmd_len-1 ))
 		{
 			g_state=SEARCHING;
 			g_start_search=FALSE;
 			g_break_search=FALSE;
-
-			TimeControl(&g_tc);
+			g_search_ended=FALSE;
+			g_ev_end_valid=FALSE;
+			g_stop_pending=FALSE;
+			g_stop_move[0]='\0';
+			xcmd_info.PV[0]='\0';
+
+			if (g_bridge.bm_reset!=NULL)			//Ende einer Suche nach Ablauf der Frist verwerfen
+				g_bridge.bm_reset();
+
+			SearchTimersReset();
+			TimeControl(machine,&g_tc);
+			if (g_unlimited && g_tc.fixmovetime!=0xffffffff &&		//Unendlich (analyze, go infinite/ponder) ohne Grenze
+				!CycleBudgetStart(machine,&g_tc) && g_vclock)
+				VClockStart(machine,&g_tc);
 		}
 
 		g_last_cmd=g_cmd[g_cmd_inx];
@@ -2558,6 +7124,9 @@ static void ProcessSENDCOMMAND(running_machine *machine)
 //------------------------------
 static void ProcessSPECIALCOMMANDS(void)
 {
+	if (g_keyscans && !g_portIsReady)				//Taste noch im Tastenfeld, Wartezeit ab Loslassen
+		return;
+
 // Taste m = MEMO
 //
 	if (g_last_cmd=='m')							//Taste m = memo
@@ -2568,6 +7137,7 @@ static void ProcessSPECIALCOMMANDS(void)
 				g_portIsReady)
 			{
 				PrintAndLog("Repeat command m (MEM)\n");
+				g_hs_fail++;
 
 				g_cmd_inx--;
 
@@ -2593,6 +7163,7 @@ static void ProcessSPECIALCOMMANDS(void)
 				g_portIsReady)						//Vor Eingabe der Promofigur Display = Pr _ nach Eingabe z.B. Pr d
 			{
 				PrintAndLog("Repeat Promo \n");
+				g_hs_fail++;
 
 				g_cmd_inx--;
 
@@ -2637,11 +7208,16 @@ static void ProcessSPECIALCOMMANDS(void)
 //------------------------------
 // ProcessBESTMOVE                                         
 //------------------------------
-static void ProcessBESTMOVE(void)
+static void ProcessBESTMOVE(running_machine *machine)
 {
+	char symmove[10];
+	char *bm=g_display;								//Bestmove aus dem Display oder aus dem RAM
+
 	g_info_index = 0;								//Index fr Infoanzeige zurcksetzen
 	g_info_start = FALSE;
 
+	SearchTimersReset();
+
 	if(g_unlimited)
 	{
 		if (g_tc.movestogo > 0)
@@ -2652,11 +7228,35 @@ static void ProcessBESTMOVE(void)
 		}
 	}
 
-	strcpy(g_bestmove,g_display);
-	g_bestmove[0]=tolower(g_display[0]);							 
-	g_bestmove[2]=tolower(g_display[2]);							 												 
+	if (g_ev_end_valid)								//Latenz Ende Suche -> Bestmove (Event oder BM_Check)
+	{
+		EvLatency(&g_ev_stat_bm,g_ev_search_end,timer_get_time(machine));
+		g_ev_end_valid=FALSE;
+	}
+
+	if (g_stop_pending)								//Latenz Abbruch -> Bestmove
+	{
+		EvLatency(&g_ev_stat_stop,g_stop_time,timer_get_time(machine));
+		g_stop_pending=FALSE;
+	}
+
+	if (SymReadBestmove(machine,symmove))
+	{
+		Log("Bestmove from RAM: %s (Display: %s)\n",symmove,g_display);
+		bm=symmove;
+	}
+
+	if (g_stop_move[0]!='\0')						//Zug nach Ablauf der Frist schon gesendet
+	{
+		StopMoveCheck(machine,bm);
+		return;
+	}
+
+	strcpy(g_bestmove,bm);
+	g_bestmove[0]=tolower(bm[0]);							 
+	g_bestmove[2]=tolower(bm[2]);							 												 
 
-	if (checkPromo(g_display) )						//Zug auf letze Reihe, Prfe ob Bauernumwandlung
+	if (checkPromo(bm) )						//Zug auf letze Reihe, Prfe ob Bauernumwandlung
 	{
 		g_state=BESTMOVEPROMO;
 
@@ -2671,7 +7271,9 @@ static void ProcessBESTMOVE(void)
 	}else
 	{
 		g_bestmove[4]='\n';						
+		PonderPrepare(g_bestmove);
 		SendBestmoveToGUI(g_bestmove);
+		PlyAdvance();
 		g_bestmove[0]='\0';
 		g_state=DRIVER_READY;		
 	}
@@ -2728,7 +7330,7 @@ static void ProcessBESTMOVEPROMO(running_machine *machine)
 // Keine Infoanzeige, dann weiter
 //
 			keycode=GetKeycode(g_keys,g_cmd[g_cmd_inx]);
-			input_port_set(machine,keycode->name,keycode->data);
+			KeypadPress(machine,keycode);
 
 			g_displayChanged=FALSE;
 			g_portIsReady=FALSE;
@@ -2744,6 +7346,7 @@ static void ProcessBESTMOVEPROMO(running_machine *machine)
 			strcat(g_bestmove,"\n");
 
 			SendBestmoveToGUI(g_bestmove);
+			PlyAdvance();
 			g_bestmove[0]='\0';
 
 			g_state=DRIVER_READY;
@@ -2772,30 +7375,48 @@ int mame_execute(core_options *options)
 	int error = MAMERR_NONE;
 	int firstgame = TRUE;
 	int firstrun = TRUE;
+	int drain;					//MOD RS
+	int i;						//MOD RS
 
 //--------------------------------------------------------------------------
 // Begin of   MOD RS
 //--------------------------------------------------------------------------
 
-	Thandle hThread;			// Handles auf die Threads
-	int  dwThreadID;			// IDs der Threads
+// Client fuer den Fork Server, startet keine Emulation
+//
+	if (options_get_string(options,"mmforkconnect")[0]!='\0')
+		return ForkConnect(options_get_string(options,"mmforkconnect"));
+
+// Ein-/Ausgabe der Engine, ohne AttachEngineIO ueber stdin/stdout
+//
+	if (g_io==NULL)
+	{
+		setvbuf(stdin,NULL,_IONBF,0);
+		setvbuf(stdout,NULL,_IOFBF,OUT_QUEUE_SIZE*OUT_LINE_MAX);	//Ausgabe nur ueber den Output Thread
+
+		AttachEngineIO(stdin,stdout,NULL);
+	}
 
-	setvbuf(stdin,NULL,_IONBF,0);
-	setvbuf(stdout,NULL,_IONBF,0);
+// Tuning der Handshake Wartezeiten, die Maschine laeuft in einem eigenen Thread
+//
+	if (options_get_bool(options,"mmtune"))
+		return TuneMaster(options);
 
-// Initialisiere Mutex und Condition Vars -> nur Linux
+// Match, beide Maschinen laufen in eigenen Threads dieses Prozesses
 //
-    LockCondMutex(MutexAvailable);
-	LockCondMutex(MutexProcessed);
+	if (options_get_string(options,"mmmatch")[0]!='\0')
+		return MatchMaster(options);
 
-//  Events erzeugen
+// EPD Testlauf, der Master verteilt nur die Stellungen auf die Worker
 //
-	CreateEventOrCond(HInputProcessed);
-	CreateEventOrCond(HInputAvailable);
+	if (options_get_string(options,"mmepd")[0]!='\0' && EpdMaster(options,&error))
+		return error;
 
-// Thread erzeugen
+// Thread erzeugen, beim Fork Server erst im Kindprozess
 //
-	BeginThread(hThread,ThreadFuncCheckInput,INPUT_TH,dwThreadID)
+	strncpy(g_fork_path,options_get_string(options,"mmforkserver"),sizeof(g_fork_path)-1);
+	if (g_fork_path[0]=='\0' || g_epd_mode)
+		StartThreads();
 
 //--------------------------------------------------------------------------
 // End of   MOD RS
@@ -2846,6 +7467,17 @@ int mame_execute(core_options *options)
 //--------------------------------------------------------------------------
 
 		g_mmlog				=	options_get_bool(mame_options(),"mmlog");				//Logfile an ?
+		g_io->log_max		=	options_get_int(mame_options(),"mmlogsize")*1024L;		//max. Groesse Logfile
+		g_inject			=	options_get_bool(mame_options(),"mminject");			//Zuege direkt ins RAM schreiben
+		g_setboard			=	options_get_bool(mame_options(),"mmsetboard");			//setboard direkt ins RAM schreiben
+		g_settle_us			=	options_get_int(mame_options(),"mmsettle")*1000;		//Display stabil nach Ende Suche (ms Emulatorzeit)
+		g_poll_wait			=	options_get_int(mame_options(),"mmpollwait");			//Timeout Abfrage Eingabe (ms), 0 = nicht blockieren
+		g_vclock			=	options_get_bool(mame_options(),"mmvclock");			//Zeitkontrolle in Emulatorzeit
+		g_keyscans			=	options_get_int(mame_options(),"mmkeyscans");			//Tasten nach n Abfragen durch das ROM loslassen
+		g_stop_deadline		=	options_get_int(mame_options(),"mmstopdeadline");		//Frist Abbruch -> Zug (ms), danach bester Zug bisher
+		g_ponder_option		=	options_get_bool(mame_options(),"mmponder");			//Pondern bei mmunlimited nach "hard"
+		g_snapshot			=	options_get_int(mame_options(),"mmsnapshot");			//Zustand nach dem Start fuer "new" (1), auch auf Platte (2)
+		g_plysnaps			=	MIN(options_get_int(mame_options(),"mmplysnaps"),PLY_SNAPS_MAX);	//Zustand je Halbzug fuer undo/remove
 		g_unlimited			=	options_get_bool(mame_options(),"mmunlimited");			//Maximale Geschwindigkeit
 		g_option_tc_delay	=	options_get_bool(mame_options(),"mmtcdelay");			//Eingabe Korrekturwert Zeitkontrolle
 
@@ -2859,8 +7491,17 @@ int mame_execute(core_options *options)
 
 		g_profiler=FALSE;		//Profiler an/ausschalten (im Logfile wird das Profilerergebeniss angezeigt) nur zum Testen, nur bei DEBUG=1
 
-		strcat(g_logfile,driver->name);
-		strcat(g_logfile,".txt");
+		strcat(g_io->logfile,driver->name);
+		strcat(g_io->logfile,".txt");
+
+		g_snap_tag=(UINT32) osd_ticks();
+		for (i=0; i<PLY_SNAPS_MAX; i++)
+			g_ply_snap[i].ply=-1;
+
+		if (g_snapshot==2)
+			sprintf(g_snap_name,SNAP_FILE,driver->name);
+		else if (g_snapshot==1)															//Eindeutiger Name, mehrere Prozesse je Modul
+			sprintf(g_snap_name,SNAP_TMP_FILE,driver->name,g_snap_tag);
 
 		if (g_unlimited && g_option_tc_delay==0)										//Performancemessung nur wenn mmunlimited und keine Korrekturvoragbe ber mmtcdelay
 			g_per_wait=600;
@@ -3716,6 +8357,11 @@ int mame_execute(core_options *options)
 
 		}
 
+// Handshake Wartezeiten: Werte der Modultabelle merken, Profil aus -mmtune laden
+//
+		HsGet(g_hs_default);
+		HsLoad(driver->name);
+
 // Initialisierungen
 //
 
@@ -3735,11 +8381,26 @@ int mame_execute(core_options *options)
 		g_start_time_sc=0;
 		g_end_time_sc=0;
 		g_time_per_sec=0;
+		g_calib_cached=FALSE;
+		g_calib_start=0;
+		g_vclock_timer=NULL;							//Timer gehoeren zur Maschine
+		g_cycle_timer=NULL;
+		g_cycle_budget=FALSE;
 	
 		g_TimeCheck=TIMECHECK;
 
 		g_bestmove[0]='\0';
 
+		memset(&g_bridge,0,sizeof(g_bridge));			//wird vom Treiber gesetzt
+
+		g_ev_head=g_ev_tail=0;							//Ereignis-Warteschlange
+		g_search_ended=FALSE;
+		g_ev_end_valid=FALSE;
+		g_ev_key_pending=FALSE;
+		KeypadReset();
+
+		LoadSymbols(driver->name);						//RAM-Adressen Bestmove, Infozeile
+
 		//g_stat.cpuexec_timeslice=0;
 		//g_stat.timercb=0;
 		//g_stat.endtime=0;
@@ -3814,18 +8475,38 @@ int mame_execute(core_options *options)
 				if (g_profiler)	
 					LogProfiler(machine);
 
+				ProcessEvents(machine);						//Ereignisse vom Treiber
+
+				drain=INPUT_DRAIN;							//Mehrere Eingaben pro Zeitscheibe (time, otim, force, ...)
+				while (g_state==PARSEINPUT && drain-- > 0)
+				{
+					ProcessPARSEINPUT(machine);
+
+					if (g_state==DRIVER_READY && WaitInputAvailable(0))
+					{
+						g_last_cmd='\0';
+						g_state=PARSEINPUT;
+					}
+				}
+
 				switch (g_state)
 				{
 
 					case DRIVER_START: 
 					{
 						ProcessDRIVER_START(machine);
+
+						if (g_state==DRIVER_READY && !g_io->threads_started)		//Fork Server: Modul ist bereit
+						{
+							ForkServer(machine);
+							StartThreads();
+						}
 						break;
 					}
 
 					case DRIVER_READY: 
 					{
-						ProcessDRIVER_READY();
+						ProcessDRIVER_READY(machine);
 						break;
 					}
 
@@ -3835,6 +8516,12 @@ int mame_execute(core_options *options)
 						break;
 					}
 
+					case PONDERING: 
+					{
+						ProcessPONDERING(machine);
+						break;
+					}
+
 					case PARSEINPUT:
 					{
 						ProcessPARSEINPUT(machine);
@@ -3855,7 +8542,7 @@ int mame_execute(core_options *options)
 
 					case BESTMOVE:
 					{
-						ProcessBESTMOVE();
+						ProcessBESTMOVE(machine);
 						break;
 					}
 
@@ -3889,7 +8576,18 @@ int mame_execute(core_options *options)
 				profiler_mark_end();
 			}
 
-			exit_flag=TRUE;			//MOD RS
+			g_io->exit_flag=TRUE;	//MOD RS
+			OutputDrain();			//MOD RS
+			LogEventStat();			//MOD RS
+			OvhSave();				//MOD RS
+			Log("Output: %u lines dropped\n",g_out_dropped);	//MOD RS
+			Log("Ponder: %u hits, %u misses\n",g_ponder_hits,g_ponder_misses);	//MOD RS
+			Log("Input polling: %u calls, %u ms wall time blocked, %u coalesced\n",g_poll_calls,	//MOD RS
+				(UINT32) (g_poll_ticks*1000/osd_ticks_per_second()),g_in_coalesced);					//MOD RS
+			if (g_snapshot==1 && g_snap_owner)	//MOD RS
+				osd_rmfile(g_snap_path);		//MOD RS
+			PlySnapExit();			//MOD RS
+			LogDrain();				//MOD RS
 
 			/* and out via the exit phase */
 			mame->current_phase = MAME_PHASE_EXIT;
@@ -4944,6 +9642,8 @@ static void init_machine(running_machine *machine)
 	/* this must be done before cpu_init so that CPU's can allocate timers */
 	timer_init(machine);
 	mame->soft_reset_timer = timer_alloc(machine, soft_reset, NULL);
+	g_vclock_timer = timer_alloc(machine, VClockExpired, NULL);			//MOD RS vor Ende der Registrierung
+	g_cycle_timer = timer_alloc(machine, CycleBudgetExpired, NULL);		//MOD RS
 
 	/* init the osd layer */
 	//osd_init(machine);	//MOD RS
@@ -6,6 +6,8 @@
 //#define POSIX 1
 
 #define INPUT_TH	1
+#define OUTPUT_TH	2
+#define LOG_TH		3
 
 #define FALSE 0
 #define TRUE 1
@@ -61,6 +63,15 @@
 
 #endif
 
+// Zustand der Bridge und der Treiber gehoert zum Emulationsthread
+// Laufen mehrere Engines in einem Prozess, hat jeder Emulationsthread seine eigene Kopie
+//
+#if defined(_MSC_VER)
+#define MM_TLS	__declspec(thread)
+#else
+#define MM_TLS	__thread
+#endif
+
 // Zeitsteuerung
 //
 #ifdef linux		//Linux
@@ -103,6 +114,7 @@ typedef struct timecontrol {
 	UINT32 movestogo_start;
 	 INT32 movetime;
 	UINT64 starttime;
+	attotime vstart;						// Start Suche in Emulatorzeit (-mmvclock)
 	int side;
 }TC_T;
 
@@ -128,6 +140,76 @@ typedef struct emu_key_struct
 	int data;
 }EMU_KEY_T;
 
+// Schnittstelle Bridge <-> Treiber
+// Die Funktionen werden vom Treiber gesetzt, NULL = nicht vorhanden (dann Eingabe ueber Tasten)
+//
+typedef struct emu_bridge_struct
+{
+	int (*inject_move)(running_machine *machine, char *move, int force);	//Zug direkt ins RAM schreiben
+	int (*set_board)(running_machine *machine, char *fen);					//Stellung (FEN) direkt ins RAM schreiben
+	void (*bm_reset)(void);													//Bestmove wurde ueber Event gesendet
+}EMU_BRIDGE_T;
+
+// Ereignisse Treiber -> Bridge, Zeitstempel in Emulatorzeit
+//
+#define EV_DISPLAY_SETTLED	1		// Display vollstaendig neu geschrieben
+#define EV_SEARCH_ENDED		2		// Suche beendet (LED, LCD-Flag, IRQ)
+#define EV_ERROR_SHOWN		3		// Err1..Err3 im Display
+
+#define EV_QUEUE_SIZE		64		// 2er-Potenz
+#define KEYPAD_QUEUE_SIZE	16		// Tastenfeld, 2er-Potenz
+
+typedef struct emu_event_struct
+{
+	int		 type;
+	attotime time;
+	char	 display[10];
+}EMU_EVENT_T;
+
+// Latenzen der Bridge in emulierten Mikrosekunden
+//
+typedef struct ev_stat_struct
+{
+	UINT32 count;
+	UINT64 sum;
+	UINT64 max;
+}EV_STAT_T;
+
+// Symboltabelle: RAM-Adressen der Suchdaten je Modul
+// Adresse 0 = nicht bekannt, dann Auswertung ueber das Display
+// Nur ueber die Datei sym_<modul>.txt, im Programm sind keine Adressen hinterlegt
+//
+#define SQ_MM		0				// Brett wie beim MM IV, 10 Felder je Linie (a1=1, a8=8, b1=11, h8=78)
+#define SQ_0X88		1				// 0x88 Brett (a1=0x00, h8=0x77)
+#define SQ_64		2				// 64 Felder (a1=0, h8=63)
+
+#define SYM_PV_MAX	4				// Max. Anzahl Zuege Hauptvariante
+#define SYM_PIECES	13				// Figurcodes leer,P,N,B,R,Q,K,p,n,b,r,q,k
+
+typedef struct emu_symbols_struct
+{
+	char	module[20];
+	offs_t	bestmove;				// von,nach je 1 Byte
+	offs_t	pv;						// Hauptvariante, je Zug 2 Byte von,nach
+	int		pv_len;					// Anzahl Zuege Hauptvariante
+	offs_t	depth;					// Suchtiefe 1 Byte
+	offs_t	score;					// Bewertung 2 Byte in Centibauern (signed)
+	offs_t	nodes;					// Knotenzaehler 4 Byte
+	int		big_endian;				// 68000 = TRUE, 6502 = FALSE
+	int		sq_type;				// SQ_MM, SQ_0X88, SQ_64
+	offs_t	stop;					// Abbruchflag der Suche 1 Byte, 0 = Taste ENT
+	UINT8	stop_value;				// Wert fuer Abbruch
+	offs_t	board;					// Brett fuer setboard (Felder wie sq_type), 0 = ueber Tasten
+	offs_t	board2;					// Zweite Kopie z.B. Ausgangsstellung, 0 = keine
+	UINT8	pieces[SYM_PIECES];		// Figurcodes im RAM
+	offs_t	side;					// Seite am Zug 1 Byte
+	UINT8	side_white;
+	UINT8	side_black;
+	offs_t	castle;					// Rochaderechte 1 Byte, Bits K=1 Q=2 k=4 q=8
+	offs_t	ep;						// En passant Feld 1 Byte (wie sq_type)
+	UINT8	ep_none;				// Wert ohne en passant Feld
+}EMU_SYMBOLS_T;
+
 #include <stdio.h>
 #include <string.h>
 
@@ -139,6 +221,7 @@ typedef struct emu_key_struct
 #define SPECIALCOMMANDS 5
 #define BESTMOVE		6
 #define BESTMOVEPROMO	7
+#define PONDERING		8
 
 #define MM_KEYS				0
 #define GLASGOW_KEYS		1
@@ -147,40 +230,70 @@ typedef struct emu_key_struct
 #define EMU_MM			0
 #define EMU_GLASGOW		1
 
-extern int g_state;
-extern int g_error;
-extern int g_displayChanged;
-extern int g_portIsReady;
+extern MM_TLS int g_state;
+extern MM_TLS int g_error;
+extern MM_TLS int g_displayChanged;
+extern MM_TLS int g_portIsReady;
 
-extern unsigned int	g_inputCnt;
-extern unsigned int	g_waitCnt;
+extern MM_TLS unsigned int	g_inputCnt;
+extern MM_TLS unsigned int	g_waitCnt;
 
-extern int g_bestmoveWait;
-extern int g_inputWait;
-extern int g_promoWait;
-extern int g_inputTimeout;
+extern MM_TLS int g_bestmoveWait;
+extern MM_TLS int g_inputWait;
+extern MM_TLS int g_promoWait;
+extern MM_TLS int g_inputTimeout;
+extern MM_TLS unsigned int g_hs_fail;
+extern MM_TLS int g_keyscans;
 
-extern char g_debug;
-extern char g_display[10];
+extern MM_TLS char g_debug;
+extern MM_TLS char g_display[10];
 extern char g_segment[128];
 
-extern char g_logfile[20];
-extern int g_mmlog;
+extern MM_TLS int g_mmlog;
+
+extern MM_TLS int g_unlimited;
+extern MM_TLS int g_clock;
+
+extern MM_TLS int g_perf;
+extern MM_TLS int g_profiler;
+
+extern MM_TLS int g_xboard_mode;
 
-extern int g_unlimited;
-extern int g_clock;
+extern MM_TLS int g_inject;
 
-extern int g_perf;
-extern int g_profiler;
+extern MM_TLS EMU_BRIDGE_T g_bridge;
 
-extern int g_xboard_mode;
+extern MM_TLS EMU_SYMBOLS_T g_sym;
 
 ////extern STAT_T g_stat;
 
+// Log Level, nicht aktivierte Level werden nicht mit uebersetzt
+// Log() = LOG_LEVEL_INFO
+//
+#define LOG_LEVEL_ERROR		1
+#define LOG_LEVEL_INFO		2
+#define LOG_LEVEL_DEBUG		3
+
+#if !defined (MMLOG_LEVEL)
+	#define MMLOG_LEVEL		LOG_LEVEL_INFO
+#endif
+
+#if MMLOG_LEVEL >= LOG_LEVEL_DEBUG
+	#define LogDebug		Log
+#else
+	#define LogDebug(...)	do {} while (0)
+#endif
+
 void Log(const char *string, ...);
 void PrintAndLog(const char *string, ...);
 int TestMove( char* move);
 char *PrintState(int inp);
 void SendToGUI(char* cmd);
+void EchoDisplay(const char *display);
+int SymReadBestmove(running_machine *machine, char *move);
+void PostEvent(running_machine *machine, int type);
+void KeypadPress(running_machine *machine, EMU_KEY_T *key);
+void KeypadScan(running_machine *machine, const char *row, int select);
+void AttachEngineIO(FILE *in, FILE *out, const char *logname);
 
 #endif  //MODRS_H
@@ -148,7 +148,7 @@ struct _video_global
 ***************************************************************************/
 
 /* global state */
-static video_global global;
+static MM_TLS video_global global;		//MOD RS je Maschine (Emulationsthread), sonst Match mit zwei Maschinen
 
 /* frameskipping tables */
 static const UINT8 skiptable[FRAMESKIP_LEVELS][FRAMESKIP_LEVELS] =
@@ -37,24 +37,25 @@ sp_rinter@gmx.de
 
 #define BM_REPEAT	2					//MOD RS Wiederholung Suche Bestmove
 
-static char saveDisplay[10]="    ";		//MOD RS
+static MM_TLS char saveDisplay[10]="    ";		//MOD RS
 
-static int sendBM=FALSE;				//MOD RS
-static int sendBM_delay=0;				//MOD RS	//Zhler Wartezeit Bis Besmove gesendet werden kann
-static int sendBM_repeat=BM_REPEAT;		//MOD RS
+static MM_TLS int sendBM=FALSE;				//MOD RS
+static MM_TLS int sendBM_delay=0;				//MOD RS	//Zhler Wartezeit Bis Besmove gesendet werden kann
+static MM_TLS int sendBM_repeat=BM_REPEAT;		//MOD RS
 
-static UINT8 key_low,
+static MM_TLS UINT8 key_low,
        key_hi,
        key_select,
        irq_flag,
        lcd_invert,
        key_selector;
-static UINT8 board_value;
-static UINT16 beeper;
+static MM_TLS UINT8 board_value;
+static MM_TLS UINT16 beeper;
 
-static int irq_edge=0x00;
+static MM_TLS int irq_edge=0x00;
 
-static void read_display (UINT8 lcd_data);		//MOD RS
+static void read_display (running_machine *machine, UINT8 lcd_data);		//MOD RS
+static void BM_Reset(void);											//MOD RS
 
 // Used by Glasgow and Dallas
 static WRITE16_HANDLER ( write_lcd_gg )
@@ -62,7 +63,7 @@ static WRITE16_HANDLER ( write_lcd_gg )
   UINT8 lcd_data;
   lcd_data = data>>8;
   if (led7==0)						//MOD RS
-	  read_display(lcd_data);		//MOD RS
+	  read_display(space->machine,lcd_data);		//MOD RS
 
   lcd_shift_counter--;
   lcd_shift_counter&=3;
@@ -93,7 +94,7 @@ static WRITE16_HANDLER ( write_lcd )
   output_set_digit_value(lcd_shift_counter,lcd_invert&1?lcd_data^0xff:lcd_data);
 
   if (led7==0)						//MOD RS
-	 read_display(lcd_data);		//MOD RS
+	 read_display(space->machine,lcd_data);		//MOD RS
 
   lcd_shift_counter--;
   lcd_shift_counter&=3;
@@ -125,8 +126,11 @@ static WRITE16_HANDLER ( write_lcd_flag_gg )
   if (lcd_flag == 0) key_selector=1;
   if (lcd_flag!=0) led7=255;else led7=0;
 
-  if (lcd_flag==1 && g_state==SEARCHING)						//MOD RS	Warten wenn Suche beendet wird
+  if (lcd_flag==1 && (g_state==SEARCHING || g_state==PONDERING))	//MOD RS	Warten wenn Suche beendet wird (auch Ende Ponder)
+  {																//MOD RS
 	sendBM=TRUE;												//MOD RS    Bestmove wird in timer routine gesendet
+	PostEvent(space->machine,EV_SEARCH_ENDED);					//MOD RS
+  }																//MOD RS
 }
 
 static WRITE16_HANDLER ( write_keys )
@@ -190,8 +194,11 @@ static WRITE16_HANDLER ( write_irq_flag )
  running_device *speaker = devtag_get_device(space->machine, "beep");
  beep_set_state(speaker, data&0x100);
 
- if ( g_state==SEARCHING )		//MOD RS
+ if ( g_state==SEARCHING || g_state==PONDERING )		//MOD RS	auch Ende Ponder
+ {								//MOD RS
 	  sendBM=TRUE;				//MOD RS
+	  PostEvent(space->machine,EV_SEARCH_ENDED);	//MOD RS
+ }								//MOD RS
 
  //logerror("Write 0x800004   = %x \n  ",data);
  irq_flag=1;
@@ -217,7 +224,12 @@ static READ16_HANDLER(read_keys) // Glasgow, Dallas
 	  data=data&0x200;
   }
 
-	if (data!=0x300 && (g_displayChanged  || 			    //MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
+	if (g_keyscans)											//MOD RS Virtuelles Tastenfeld, abgefragt wird die Taste key_select
+	{														//MOD RS
+		KeypadScan(space->machine,"LINE0",key_select);		//MOD RS
+		KeypadScan(space->machine,"LINE1",key_select);		//MOD RS
+	}														//MOD RS
+	else if (data!=0x300 && (g_displayChanged  || 			    //MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
 		               (g_waitCnt > g_inputTimeout ) ) )	//MOD RS Timeout warten auf Rckmeldung (z.B. beim Info Befehl zur Abfrage Promo
 														    //MOD RS oder LEV 
 	{
@@ -241,7 +253,9 @@ static READ16_HANDLER(read_newkeys16)  //Amsterdam, Roma
 	 data=input_port_read(space->machine, "LINE1");
 
 
-	if (data && (g_displayChanged || 						//MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
+	if (g_keyscans)											//MOD RS Virtuelles Tastenfeld, loslassen nach n Abfragen der Zeile
+		KeypadScan(space->machine,key_selector==0 ? "LINE0" : "LINE1",-1);	//MOD RS
+	else if (data && (g_displayChanged || 						//MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
 		               (g_waitCnt > g_inputTimeout ) ) )	//MOD RS Timeout warten auf Rckmeldung (z.B. beim Info Befehl zur Abfrage Promo
 														    //MOD RS oder LEV 
 	{
@@ -301,7 +315,7 @@ static WRITE32_HANDLER ( write_lcd32 )
   output_set_digit_value(lcd_shift_counter,lcd_invert&1?lcd_data^0xff:lcd_data);
 
   if (led7==0)						//MOD RS
-	 read_display(lcd_data);		//MOD RS
+	 read_display(space->machine,lcd_data);		//MOD RS
 
   lcd_shift_counter--;
   lcd_shift_counter&=3;
@@ -356,7 +370,9 @@ static READ32_HANDLER(read_newkeys32) // Dallas 32, Roma 32
    else
 	data =  input_port_read(space->machine, "LINE1");
 
-	if (data && (g_displayChanged || 						//MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
+	if (g_keyscans)											//MOD RS Virtuelles Tastenfeld, loslassen nach n Abfragen der Zeile
+		KeypadScan(space->machine,key_selector==0 ? "LINE0" : "LINE1",-1);	//MOD RS
+	else if (data && (g_displayChanged || 						//MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
 		               (g_waitCnt > g_inputTimeout ) ) )	//MOD RS Timeout warten auf Rckmeldung (z.B. beim Info Befehl zur Abfrage Promo
 														    //MOD RS oder LEV 
 	{
@@ -415,8 +431,11 @@ running_device *speaker = devtag_get_device(space->machine, "beep");
  irq_flag=1;
  beeper=data;
 
- if ( g_state==SEARCHING )		//MOD RS
+ if ( g_state==SEARCHING || g_state==PONDERING )		//MOD RS	auch Ende Ponder
+ {								//MOD RS
 	 sendBM=TRUE;				//MOD RS
+	 PostEvent(space->machine,EV_SEARCH_ENDED);	//MOD RS
+ }								//MOD RS
 	
 //  Log("Beep out data: %x\n!",data);
 }
@@ -427,13 +446,25 @@ static TIMER_CALLBACK( update_waitCnt )		//MOD RS
 }											//MOD RS
 
 
+static void BM_Reset(void)					//MOD RS   Bestmove wurde ueber Event gesendet
+{											//MOD RS
+	sendBM=FALSE;							//MOD RS
+	sendBM_repeat=BM_REPEAT;				//MOD RS
+	sendBM_delay=g_bestmoveWait;			//MOD RS
+}											//MOD RS
+
 static TIMER_CALLBACK( BM_Check )			//MOD RS
 {
+	char symmove[10];						//MOD RS
+	char result[20];						//MOD RS
+	int ram_bm;								//MOD RS
+
 	if (sendBM && g_state==SEARCHING)		//MOD RS   Verzgerung bei Ausgabe bestmove
 	{										//MOD RS
-		if (sendBM_delay==0)				//MOD RS
+		ram_bm=SymReadBestmove(machine,symmove);	//MOD RS   Bestmove aus dem RAM -> keine Wartezeit
+		if (sendBM_delay==0 || ram_bm)		//MOD RS
 		{									//MOD RS
-			if (TestMove(g_display) )		//MOD RS
+			if (TestMove(g_display) || ram_bm)	//MOD RS
 			{								//MOD RS
 				g_state=BESTMOVE;			//MOD RS
 				sendBM=FALSE;					//MOD RS
@@ -451,7 +482,8 @@ static TIMER_CALLBACK( BM_Check )			//MOD RS
 			{																//MOD RS
 				Log("Draw: %s\n",g_display);								//MOD RS
 
-				SendToGUI((char *)"1/2-1/2\n");								//MOD RS
+				sprintf(result,"1/2-1/2 {%s}\n",g_display);				//MOD RS   Grund fuer GUI/Match
+				SendToGUI(result);											//MOD RS
 				g_state=DRIVER_READY;										//MOD RS
 			}																//MOD RS
 			else									//MOD RS	
@@ -461,6 +493,7 @@ static TIMER_CALLBACK( BM_Check )			//MOD RS
 				{									//MOD RS
 					sendBM_repeat--;				//MOD RS
 					sendBM_delay=g_bestmoveWait;	//MOD RS
+					g_hs_fail++;					//MOD RS   Display noch ohne Zug (-mmtune)
 					PrintAndLog("No BestMove:   %s try again - wait for %d waitCnt\n",g_display,g_bestmoveWait);	//MOD RS
 				}else								//MOD RS
 				{
@@ -526,12 +559,24 @@ static MACHINE_START( glasgow )
 
 	beep_set_frequency(speaker, 44);
 
+	state_save_register_global(machine,key_low);			//MOD RS  Schnappschuss nach dem Start
+	state_save_register_global(machine,key_hi);				//MOD RS
+	state_save_register_global(machine,key_select);			//MOD RS
+	state_save_register_global(machine,irq_flag);			//MOD RS
+	state_save_register_global(machine,lcd_invert);			//MOD RS
+	state_save_register_global(machine,key_selector);		//MOD RS
+	state_save_register_global(machine,board_value);		//MOD RS
+	state_save_register_global(machine,beeper);				//MOD RS
+	state_save_register_global(machine,irq_edge);			//MOD RS
+	state_save_register_global(machine,lcd_shift_counter);	//MOD RS
+	state_save_register_global(machine,led7);				//MOD RS
 	state_save_register_global_array(machine,save_board);
 	state_save_register_postload(machine,m_board_postload,NULL);
 	state_save_register_presave(machine,m_board_presave,NULL);
 
 	sendBM_delay=g_bestmoveWait;		//MOD RS
 	sendBM_repeat=BM_REPEAT;			//MOD RS
+	g_bridge.bm_reset=BM_Reset;			//MOD RS
 
 }
 
@@ -549,6 +594,17 @@ static MACHINE_START( dallas32 )
 
 	beep_set_frequency(speaker, 44);
 
+	state_save_register_global(machine,key_low);			//MOD RS  Schnappschuss nach dem Start
+	state_save_register_global(machine,key_hi);				//MOD RS
+	state_save_register_global(machine,key_select);			//MOD RS
+	state_save_register_global(machine,irq_flag);			//MOD RS
+	state_save_register_global(machine,lcd_invert);			//MOD RS
+	state_save_register_global(machine,key_selector);		//MOD RS
+	state_save_register_global(machine,board_value);		//MOD RS
+	state_save_register_global(machine,beeper);				//MOD RS
+	state_save_register_global(machine,irq_edge);			//MOD RS
+	state_save_register_global(machine,lcd_shift_counter);	//MOD RS
+	state_save_register_global(machine,led7);				//MOD RS
 	state_save_register_global_array(machine,save_board);
 	state_save_register_postload(machine,m_board_postload,NULL);
 	state_save_register_presave(machine,m_board_presave,NULL);
@@ -556,6 +612,7 @@ static MACHINE_START( dallas32 )
 
 	sendBM_delay=g_bestmoveWait;		//MOD RS
 	sendBM_repeat=BM_REPEAT;			//MOD RS
+	g_bridge.bm_reset=BM_Reset;			//MOD RS
 
 }
 
@@ -791,7 +848,7 @@ CONS(  1984, dallas16, 0,        0,    amsterd,       new_keyboard,   0,	   "Heg
 
 
 
-static void read_display (UINT8 lcd_data)
+static void read_display (running_machine *machine, UINT8 lcd_data)
 {
 	output_set_digit_value(lcd_shift_counter,lcd_data);
 
@@ -813,9 +870,9 @@ static void read_display (UINT8 lcd_data)
 		//if (!(g_state==SEARCHING	&&				//MOD RS		Keine Displayausgabe whrend der Suche
 		//	  g_unlimited			&&				//MOD RS		Viele Ausgaben besonders bei g_unlimited
 		//	  g_xboard_mode) )						//MOD RS
-			printf("%s\n",g_display);				//MOD RS
+			EchoDisplay(g_display);					//MOD RS
 
-		Log("Display: %s\n",g_display);				//MOD RS
+		LogDebug("Display: %s\n",g_display);				//MOD RS
 
 		if (!strncmp(g_display,"Err1",4) ||			//MOD RS
 			!strncmp(g_display,"Err2",4) ||			//MOD RS
@@ -823,12 +880,16 @@ static void read_display (UINT8 lcd_data)
 		{											//MOD RS
 			g_error=TRUE;							//MOD RS
 			g_state=DRIVER_READY;					//MOD RS
+			PostEvent(machine,EV_ERROR_SHOWN);		//MOD RS
 		}											//MOD RS
 
 //			printf("g_dispayChanged\n");			//MOD RS
 
 		if (strncmp(g_display,"TIME",4))			//MOD RS Sonderfall Anzeige TIME soll nicht g_displayChanged auslsen
+		{											//MOD RS
 			g_displayChanged=TRUE;					//MOD RS
+			PostEvent(machine,EV_DISPLAY_SETTLED);	//MOD RS
+		}											//MOD RS
 		
 	}
 
@@ -85,14 +85,19 @@ $8000-$FFF ROM
 #include "mephistoboard_def.h"
 
 #include "modrs.h"						//MOD RS
-static char saveDisplay[10]="    ";		//MOD RS
+static MM_TLS char saveDisplay[10]="    ";		//MOD RS
 
-static int sendBM=FALSE;				//MOD RS
-static int sendBM_delay=0;				//MOD RS	//Zhler Wartezeit Bis Besmove gesendet werden kann
+static MM_TLS int sendBM=FALSE;				//MOD RS
+static MM_TLS int sendBM_delay=0;				//MOD RS	//Zhler Wartezeit Bis Besmove gesendet werden kann
 
 static int loadFENfile(char *buffer);
 static void setboardfromFEN(char * FEN, UINT8* hboard);
 static void put_board_to_memory_mm(UINT8* board1[64], UINT8* board2[64], UINT8* hboard);
+static void get_board_from_memory_mm(UINT8* board1[64], UINT8* hboard);			//MOD RS
+static int apply_move_to_board(UINT8* hboard, char *move);						//MOD RS
+static int inject_move_mm(running_machine *machine, char *move, int force);	//MOD RS
+static int set_board_mm(running_machine *machine, char *FEN);					//MOD RS
+static void BM_Reset(void);														//MOD RS
 
 #define MM4_WR	4
 #define MM4_WN	2
@@ -108,15 +113,15 @@ static void put_board_to_memory_mm(UINT8* board1[64], UINT8* board2[64], UINT8*
 #define MM4_BK	12
 #define MM4_BP	7
 
-static UINT8 led_status;
-static UINT8 *mephisto_ram;
+static MM_TLS UINT8 led_status;
+static MM_TLS UINT8 *mephisto_ram;
 //static UINT8 led7;
 
-static UINT8 *p_mm4_board[64];
-static UINT8 *p_mm4_board2[64];
-static UINT8 *p_mm4_bw;
+static MM_TLS UINT8 *p_mm4_board[64];
+static MM_TLS UINT8 *p_mm4_board2[64];
+static MM_TLS UINT8 *p_mm4_bw;
 
-static UINT8 board_8[64];		//for reading board from memory or FEN
+static MM_TLS UINT8 board_8[64];		//for reading board from memory or FEN
 
 
 
@@ -134,7 +139,7 @@ static UINT8 mm4_to_myboard[80] =
 
 };
 
-int started=FALSE;
+MM_TLS int started=FALSE;
 
 static DRIVER_INIT( mephisto )
 {
@@ -142,6 +147,10 @@ static DRIVER_INIT( mephisto )
 	int i=0;
 	lcd_shift_counter = 3;
 
+// RAM je Maschine, nicht ueber AM_BASE (Adresse einer MM_TLS Variablen ist keine Konstante)
+//
+	mephisto_ram = (UINT8 *) memory_get_write_ptr(cputag_get_address_space(machine, "maincpu", ADDRESS_SPACE_PROGRAM), 0x0000);	//MOD RS
+
 // initialize graphical chess board
 //
 	set_startboard_from_startpos();
@@ -160,6 +169,17 @@ static DRIVER_INIT( mephisto )
 // flag back/white ???
 //
 			p_mm4_bw = mephisto_ram+0x3f;
+
+// Zugeingabe direkt ins RAM (Brettlayout nur fuer MM IV und MM V bekannt)
+//
+	if (strcmp(machine->gamedrv->name,"rebel5") &&						//MOD RS
+		strcmp(machine->gamedrv->name,"mm2") )							//MOD RS
+	{																	//MOD RS
+		g_bridge.inject_move=inject_move_mm;							//MOD RS
+		g_bridge.set_board=set_board_mm;								//MOD RS
+	}																	//MOD RS
+
+	g_bridge.bm_reset=BM_Reset;											//MOD RS
 }
 
 static WRITE8_HANDLER ( write_lcd )
@@ -186,9 +206,9 @@ static WRITE8_HANDLER ( write_lcd )
 			//if (!(g_state==SEARCHING	&&				//MOD RS		Keine Displayausgabe whrend der Suche
 			//	  g_unlimited			&&				//MOD RS		Viele Ausgaben besonders bei g_unlimited
 			//	  g_xboard_mode) )						//MOD RS
-				printf("%s\n",g_display);				//MOD RS
+				EchoDisplay(g_display);					//MOD RS
 
-			Log("Display: %s\n",g_display);				//MOD RS
+			LogDebug("Display: %s\n",g_display);				//MOD RS
 
 			if (!strncmp(g_display,"Err1",4) ||			//MOD RS
 				!strncmp(g_display,"Err2",4) ||			//MOD RS
@@ -196,12 +216,16 @@ static WRITE8_HANDLER ( write_lcd )
 			{											//MOD RS
 				g_error=TRUE;							//MOD RS
 				g_state=DRIVER_READY;					//MOD RS
+				PostEvent(space->machine,EV_ERROR_SHOWN);	//MOD RS
 			}											//MOD RS
 
 //			printf("g_dispayChanged\n");				//MOD RS
 
 			if (strncmp(g_display,"TIME",4))			//MOD RS Sonderfall Anzeige TIME soll nicht g_displayChanged auslsen
+			{											//MOD RS
 				g_displayChanged=TRUE;					//MOD RS
+				PostEvent(space->machine,EV_DISPLAY_SETTLED);	//MOD RS
+			}											//MOD RS
 
 			
 		}
@@ -217,7 +241,7 @@ static READ8_HANDLER(read_keys)
     char fen_string[2000];
 	char keystring[10];
     UINT8 load_fen;
-	static int load_fen_flag;
+	static MM_TLS int load_fen_flag;
 
 	UINT8 data;
 	static const char *const keynames[2][8] =
@@ -234,7 +258,9 @@ static READ8_HANDLER(read_keys)
 
 	data=input_port_read(space->machine, keystring);	//MOD RS		
 
-	if (data==0 && (g_displayChanged  || 			    //MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
+	if (g_keyscans)										//MOD RS Virtuelles Tastenfeld, loslassen nach n Abfragen der Zeile
+		KeypadScan(space->machine,keystring,-1);		//MOD RS
+	else if (data==0 && (g_displayChanged  || 			    //MOD RS Rckmeldung Tastendruck erkannt (Display hat sich gendert)
 		           (g_waitCnt > g_inputTimeout ) ) )	//MOD RS Timeout warten auf Rckmeldung (z.B. beim Info Befehl zur Abfrage Promo
 														//MOD RS oder LEV 
 	{
@@ -356,8 +382,11 @@ static WRITE8_HANDLER ( write_led )
 	if (offset==7) 
 		led7= data & 0x80 ? 0x00 :0xff;
 
-	if (offset==6 && g_state==SEARCHING)						//MOD RS	Warten wenn Suche beendet wird
+	if (offset==6 && (g_state==SEARCHING || g_state==PONDERING))	//MOD RS	Warten wenn Suche beendet wird (auch Ende Ponder)
+	{															//MOD RS
 		sendBM=TRUE;											//MOD RS    Bestmove wird in timer routine gesendet
+		PostEvent(space->machine,EV_SEARCH_ENDED);				//MOD RS
+	}															//MOD RS
 
 	//Log("offset: %d data: %d Display: %s state: %s\n",offset,data,g_display,PrintState(g_state));
 
@@ -392,7 +421,7 @@ static WRITE8_HANDLER ( write_led_mm2 )
 }
 
 static ADDRESS_MAP_START(rebel5_mem , ADDRESS_SPACE_PROGRAM, 8)
-	AM_RANGE( 0x0000, 0x1fff) AM_RAM AM_BASE(&mephisto_ram)
+	AM_RANGE( 0x0000, 0x1fff) AM_RAM
 	AM_RANGE( 0x5000, 0x5000) AM_WRITE( write_lcd )
 	AM_RANGE( 0x3000, 0x3007) AM_READ( read_keys )	// Rebell 5.0
 	AM_RANGE( 0x2000, 0x2007) AM_WRITE( write_led )	// Status LEDs+ buzzer
@@ -410,7 +439,7 @@ ADDRESS_MAP_END
 
 
 static ADDRESS_MAP_START(mephisto_mem , ADDRESS_SPACE_PROGRAM, 8)
-	AM_RANGE( 0x0000, 0x1fff) AM_RAM AM_BASE(&mephisto_ram )//
+	AM_RANGE( 0x0000, 0x1fff) AM_RAM							//
 	AM_RANGE( 0x2000, 0x2000) AM_WRITE( write_lcd )
 	AM_RANGE( 0x2c00, 0x2c07) AM_READ( read_keys )
 	AM_RANGE( 0x3400, 0x3407) AM_WRITE( write_led )	// Status LEDs+ buzzer
@@ -429,7 +458,7 @@ ADDRESS_MAP_END
 
 
 static ADDRESS_MAP_START(mm2_mem , ADDRESS_SPACE_PROGRAM, 8)
-	AM_RANGE( 0x0000, 0x0fff) AM_RAM AM_BASE(&mephisto_ram )	//
+	AM_RANGE( 0x0000, 0x0fff) AM_RAM							//
 	AM_RANGE( 0x2800, 0x2800) AM_WRITE( write_lcd )				//MM2 ok
 	AM_RANGE( 0x1800, 0x1807) AM_READ( read_keys )				//MM2 ok	
 	AM_RANGE( 0x1000, 0x1007) AM_WRITE( write_led_mm2 )			//MM2 ok Status LEDs
@@ -504,14 +533,25 @@ static TIMER_CALLBACK( update_waitCnt )		//MOD RS
 }											//MOD RS
 
 
+static void BM_Reset(void)					//MOD RS   Bestmove wurde ueber Event gesendet
+{											//MOD RS
+	sendBM=FALSE;							//MOD RS
+	sendBM_delay=g_bestmoveWait;			//MOD RS
+}											//MOD RS
+
 static TIMER_CALLBACK( BM_Check )			//MOD RS
 {
+	char symmove[10];						//MOD RS
+	char result[20];						//MOD RS
+	int ram_bm;								//MOD RS
+
 	if (sendBM && g_state==SEARCHING)		//MOD RS   Verzgerung bei Ausgabe bestmove
 	{										//MOD RS
+		ram_bm=SymReadBestmove(machine,symmove);	//MOD RS   Bestmove aus dem RAM -> keine Wartezeit
 //		Log("sendBM -> sendBM_delay: %d\n",sendBM_delay);
-		if (sendBM_delay==0)				//MOD RS
+		if (sendBM_delay==0 || ram_bm)		//MOD RS
 		{									//MOD RS
-			if (TestMove(g_display) )		//MOD RS
+			if (TestMove(g_display) || ram_bm)	//MOD RS
 			{								//MOD RS
 				g_state=BESTMOVE;			//MOD RS
 			}								//MOD RS
@@ -525,7 +565,8 @@ static TIMER_CALLBACK( BM_Check )			//MOD RS
 				     !strcmp(g_display,"rE50") || !strcmp(g_display,"PATT") )	//MOD RS
 			{																//MOD RS
 				Log("Draw: %s\n",g_display);								//MOD RS
-				SendToGUI((char *)"1/2-1/2\n");								//MOD RS
+				sprintf(result,"1/2-1/2 {%s}\n",g_display);				//MOD RS   Grund fuer GUI/Match
+				SendToGUI(result);											//MOD RS
 				g_state=DRIVER_READY;										//MOD RS
 			}																//MOD RS
 			else															//MOD RS
@@ -603,6 +644,9 @@ static MACHINE_START( mm2 )
 
 	beep_set_frequency(speaker, 3500);
 
+	state_save_register_global(machine,led_status);			//MOD RS  Schnappschuss nach dem Start
+	state_save_register_global(machine,lcd_shift_counter);	//MOD RS
+	state_save_register_global(machine,led7);				//MOD RS
 	state_save_register_global_array(machine,save_board);
 	state_save_register_postload(machine,m_board_postload,NULL);
 	state_save_register_presave(machine,m_board_presave,NULL);
@@ -624,6 +668,9 @@ static MACHINE_START( mephisto )
 	//beep_set_frequency(0, 4000);
 	beep_set_frequency(speaker, 2800);
 
+	state_save_register_global(machine,led_status);			//MOD RS  Schnappschuss nach dem Start
+	state_save_register_global(machine,lcd_shift_counter);	//MOD RS
+	state_save_register_global(machine,led7);				//MOD RS
 	state_save_register_global_array(machine,save_board);
 	state_save_register_postload(machine,m_board_postload,NULL);
 	state_save_register_presave(machine,m_board_presave,NULL);
@@ -1120,3 +1167,212 @@ for (board_index =0; board_index<64;board_index++)
 
 }
 
+//------------------------------
+// get_board_from_memory_mm                                          
+//------------------------------
+// Gegenstueck zu put_board_to_memory_mm: aktuelle Stellung aus dem RAM lesen
+//
+static void get_board_from_memory_mm(UINT8* board1[64], UINT8* hboard)		//MOD RS
+{
+int board_index;
+
+static const UINT8 mm4_to_piece[13] =
+{
+	EMPTY, WP, WN, WB, WR, WQ, WK, BP, BN, BB, BR, BQ, BK
+};
+
+for (board_index =0; board_index<64;board_index++)
+{
+	if (*board1[flip[board_index]] <= MM4_BK)
+		hboard[board_index] = mm4_to_piece[*board1[flip[board_index]]];
+	else
+		hboard[board_index] = EMPTY;
+}
+
+}
+
+//------------------------------
+// apply_move_to_board                                          
+//------------------------------
+// Zug (z.B. e2e4, e7e8q) auf dem Brett ausfuehren, Index 0 = a8 wie im FEN
+// Rochade, en passant und Umwandlung werden beruecksichtigt
+//
+static int apply_move_to_board(UINT8* hboard, char *move)					//MOD RS
+{
+int from;
+int to;
+UINT8 piece;
+UINT8 promo;
+
+	from = ('8'-move[1])*8 + (tolower(move[0])-'a');
+	to   = ('8'-move[3])*8 + (tolower(move[2])-'a');
+
+	if (from<0 || from>63 || to<0 || to>63 || from==to)
+		return FALSE;
+
+	piece=hboard[from];
+	if (piece==EMPTY)
+		return FALSE;
+
+// Rochade -> Turm mitziehen
+//
+	if ((piece==WK || piece==BK) && abs(to-from)==2)
+	{
+		if (to>from)						//kurze Rochade
+		{
+			hboard[to-1]=hboard[to+1];
+			hboard[to+1]=EMPTY;
+		}
+		else								//lange Rochade
+		{
+			hboard[to+1]=hboard[to-2];
+			hboard[to-2]=EMPTY;
+		}
+	}
+
+// en passant -> geschlagenen Bauern entfernen
+//
+	if ((piece==WP || piece==BP) && (from%8)!=(to%8) && hboard[to]==EMPTY)
+		hboard[(from/8)*8+(to%8)]=EMPTY;
+
+	hboard[to]=piece;
+	hboard[from]=EMPTY;
+
+// Umwandlung, ohne Angabe Dame
+//
+	if ((piece==WP && to<8) || (piece==BP && to>55))
+	{
+		switch (tolower(move[4]))
+		{
+		case 'r':
+			promo=WR;
+			break;
+		case 'b':
+			promo=WB;
+			break;
+		case 'n':
+			promo=WN;
+			break;
+		default:
+			promo=WQ;
+			break;
+		}
+		hboard[to] = (piece==WP) ? promo : promo+(BP-WP);
+	}
+
+	return TRUE;
+}
+
+//------------------------------
+// inject_move_mm                                          
+//------------------------------
+// Zug direkt ins RAM schreiben statt ueber die Tastatur einzugeben
+// Ausserhalb force muss die Farbe zur Seite am Zug passen, sonst rechnet das Modul fuer die falsche Seite
+// Die Zugliste des ROMs wird nicht geschrieben (Adresse unbekannt), damit auch kein Rochaderecht und
+// kein en passant -> Zuege von Koenig und Turm, auf ein Eckfeld, Doppelschritt und en passant ueber Tasten
+// Rueckgabe FALSE -> Zug konnte nicht gesetzt werden, Eingabe dann ueber Tasten
+//
+static int inject_move_mm(running_machine *machine, char *move, int force)	//MOD RS
+{
+UINT8 piece;
+int from;
+int to;
+
+	get_board_from_memory_mm(p_mm4_board, board_8);
+
+	from = ('8'-move[1])*8 + (tolower(move[0])-'a');
+	to   = ('8'-move[3])*8 + (tolower(move[2])-'a');
+	if (from<0 || from>63 || to<0 || to>63)
+		return FALSE;
+
+	piece=board_8[from];
+
+	if (piece==WK || piece==BK || piece==WR || piece==BR ||			//Rochaderecht
+		to==0 || to==7 || to==56 || to==63)							//Turm in der Ecke geschlagen
+	{
+		Log("inject_move_mm: %s changes castling rights\n",move);
+		return FALSE;
+	}
+
+	if ((piece==WP || piece==BP) &&
+		(abs(to-from)==16 || ((from%8)!=(to%8) && board_8[to]==EMPTY)))	//Doppelschritt bzw. en passant
+	{
+		Log("inject_move_mm: %s needs en passant state\n",move);
+		return FALSE;
+	}
+
+	if (!force && piece!=EMPTY && ((piece>=BP) ? 0 : 1)!=*p_mm4_bw)
+	{
+		Log("inject_move_mm: %s not side to move\n",move);
+		return FALSE;
+	}
+
+	if (!apply_move_to_board(board_8, move))
+	{
+		Log("inject_move_mm: no piece on %c%c\n",move[0],move[1]);
+		return FALSE;
+	}
+
+	put_board_to_memory_mm(p_mm4_board, p_mm4_board, board_8);	//change internal board, Startstellung (0x480) bleibt
+
+	*p_mm4_bw = (piece>=BP) ? 1 : 0;								//Seite am Zug: 1=Weiss 0=Schwarz
+
+	if (artwork_view==BOARD_VIEW)
+	{
+		clear_layout();										//clear artwork layout
+		set_startboard_from_array(board_8);					//startposition for layout
+		set_render_board();									//change layout
+		set_status_of_pieces();								//set or not set pieces
+	}
+
+	return TRUE;
+}
+
+//------------------------------
+// set_board_mm                                          
+//------------------------------
+// setboard direkt ins RAM wie LOAD_FEN (F12), zusaetzlich Seite am Zug
+// Rochade und en passant: Adressen beim MM IV/V nicht bekannt, werden nicht gesetzt
+// Rueckgabe FALSE -> FEN unvollstaendig, Eingabe dann ueber Tasten
+//
+static int set_board_mm(running_machine *machine, char *FEN)				//MOD RS
+{
+int squares=0;
+int fields=1;
+char side='w';
+char *p;
+
+	for (p=FEN; *p!='\0' && *p!=' '; p++)						//setboardfromFEN prueft nicht
+	{
+		if (isdigit((UINT8) *p))
+			squares+=*p-'0';
+		else if (strchr("prnbqkPRNBQK",*p)!=NULL)
+			squares++;
+		else if (*p!='/')
+			return FALSE;
+	}
+
+	for (; *p!='\0'; p++)										//Alle 6 Teile vorhanden ?
+		if (*p==' ' && p[1]!=' ' && p[1]!='\0')
+			fields++;
+
+	if (squares!=64 || fields<6)
+		return FALSE;
+
+	sscanf(FEN,"%*s %c",&side);
+
+	setboardfromFEN(FEN, board_8);								//read FEN string in array
+	put_board_to_memory_mm(p_mm4_board, p_mm4_board2, board_8); //change internal board
+
+	*p_mm4_bw = (side=='b') ? 0 : 1;							//Seite am Zug: 1=Weiss 0=Schwarz
+
+	if (artwork_view==BOARD_VIEW)
+	{
+		clear_layout();										//clear artwork layout
+		set_startboard_from_array(board_8);					//startposition for layout
+		set_render_board();									//change layout
+		set_status_of_pieces();								//set or not set pieces
+	}
+
+	return TRUE;
+}
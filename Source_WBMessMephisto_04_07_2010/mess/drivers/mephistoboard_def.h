@@ -1,5 +1,9 @@
-static UINT8 lcd_shift_counter;
-static UINT8 led7;
+#include "modrs.h"						//MOD RS MM_TLS
+
+// Zustand je Emulationsthread (MM_TLS), mehrere Engines pro Prozess
+//
+static MM_TLS UINT8 lcd_shift_counter;
+static MM_TLS UINT8 led7;
 
   #define BOARD_VIEW	1
   #define MODULE_VIEW	2
@@ -24,8 +28,8 @@ static UINT8 led7;
   #define MIN_CURSOR_Y	0
   #define MAX_CURSOR_Y	622
 
-  static UINT16 Line18_LED;
-  static UINT16 Line18_REED;
+  static MM_TLS UINT16 Line18_LED;
+  static MM_TLS UINT16 Line18_REED;
 
   static const char EMP[4] = "EMP";
   static const char NO_PIECE[4]  = "NOP";
@@ -55,10 +59,10 @@ static UINT8 led7;
     #define EMPTY	0 
 
 
-static UINT8 save_board[64];					//for save state
+static MM_TLS UINT8 save_board[64];					//for save state
 
-static BOARD_FIELD m_board[8][8];		        //current board
-static BOARD_FIELD start_board[8][8];
+static MM_TLS BOARD_FIELD m_board[8][8];		        //current board
+static MM_TLS BOARD_FIELD start_board[8][8];
 static BOARD_FIELD start_pos[8][8] =
 	{
 		{ { 7,44,434,"WR1"}, { 6,100,434,"WN1"}, { 5,156,434,"WB1"}, { 4,212,434,"WQ1"}, { 3,268,434,"WK"}, { 2,324,434,"WB2"}, { 1,380,434,"WN2"}, { 0,436,434,"WR2"} },
@@ -82,7 +86,7 @@ static BOARD_FIELD start_pos[8][8] =
   } P_STATUS;
 
 
-	 static P_STATUS all_pieces[48] =
+	 static MM_TLS P_STATUS all_pieces[48] =
 	 {
 		 {"WR1",0,0}, {"WN1",0,0},{"WB1",0,0}, {"WQ1",0,0},  {"WK",0,0},  {"WB2",0,0}, {"WN2",0,0}, {"WR2",0,0},
 		 {"WP1",0,0}, {"WP2",0,0},{"WP3",0,0}, {"WP4",0,0}, {"WP5",0,0},  {"WP6",0,0}, {"WP7",0,0}, {"WP8",0,0},
@@ -99,7 +103,7 @@ static BOARD_FIELD start_pos[8][8] =
 
 	 };
 
-     static UINT8 start_i;
+     static MM_TLS UINT8 start_i;
 
 
 static UINT8 flip[64] =
@@ -167,9 +171,9 @@ public:
 
 
 
-  static running_machine *dummy_machine;
+  static MM_TLS running_machine *dummy_machine;
 
-  static UINT8 artwork_view;
+  static MM_TLS UINT8 artwork_view;
 
   static void set_cursor (running_machine *machine, view_item *view_cursor);
 
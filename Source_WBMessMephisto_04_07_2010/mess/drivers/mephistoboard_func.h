@@ -6,7 +6,7 @@ static void set_cursor (running_machine *machine, view_item *view_cursor)
    INT32 ui_cur_x, ui_cur_y;
    int ui_button;
 
-   static float del_x, del_y;
+   static MM_TLS float del_x, del_y;
 
 	//if ( (view_cursor->rawbounds.x0/MAX_X) > 1 )
 	//	return;	
@@ -170,7 +170,7 @@ static void update_board(render_target *target, BOARD_FIELD board_field, unsigne
  static void calculate_bounds(view_item *view_item, float new_x0, float new_y0, float new_del_x, float new_del_y )
   {
 
-   static float del_x, del_y;
+   static MM_TLS float del_x, del_y;
 
       if (new_del_x)
 		{
@@ -353,13 +353,13 @@ static void video_update(running_machine *machine, UINT8 reset)
 
 	render_target *my_target;
 
-	static view_item *my_cursor;
-	static UINT8 m_button1 , m_button2;
-	static UINT8 MOUSE_MOVE = 0;
-    static UINT8 MOUSE_BUTTON1_WAIT = 0;
-    static UINT8 MOUSE_BUTTON2_WAIT = 0;
+	static MM_TLS view_item *my_cursor;
+	static MM_TLS UINT8 m_button1 , m_button2;
+	static MM_TLS UINT8 MOUSE_MOVE = 0;
+    static MM_TLS UINT8 MOUSE_BUTTON1_WAIT = 0;
+    static MM_TLS UINT8 MOUSE_BUTTON2_WAIT = 0;
 
-	static BOARD_FIELD cursor_field;
+	static MM_TLS BOARD_FIELD cursor_field;
 
 	if (reset)
 	{
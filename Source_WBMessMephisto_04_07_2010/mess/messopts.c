@@ -36,9 +36,30 @@ const options_entry mess_core_options[] =
 	{ "newui;nu",                   "0",    OPTION_BOOLEAN,						"use the new MESS UI" },
 	{ OPTION_ADDED_DEVICE_OPTIONS,	"0",	OPTION_BOOLEAN | OPTION_INTERNAL,	"device-specific options have been added" },
 	{ "mmlog",						"0",	OPTION_BOOLEAN,						"Mephisto WB Engines: Logfile" },						//MOD RS	
+	{ "mmlogsize",					"8192",	0,									"Mephisto WB Engines: max. size of logfile in KB (0=unlimited)" },	//MOD RS
 	{ "mmunlimited",				"1",	OPTION_BOOLEAN,						"Mephisto WB Engines: max speed" },						//MOD RS
 	{ "mmclock",					"0",	0,									"Mephisto WB Engines: Clock" },							//MOD RS
 	{ "mmtcdelay",					"0",	0,									"Mephisto WB Engines: Additional time per move" },		//MOD RS
+	{ "mminject",					"0",	OPTION_BOOLEAN,						"Mephisto WB Engines: write moves direct to RAM" },		//MOD RS
+	{ "mmsetboard",					"0",	OPTION_BOOLEAN,						"Mephisto WB Engines: write setboard positions direct to RAM (driver or sym_<module>.txt)" },	//MOD RS
+	{ "mmsettle",					"200",	0,									"Mephisto WB Engines: Display stable after search (ms emulated, 0=off)" },	//MOD RS
+	{ "mmpollwait",					"0",	0,									"Mephisto WB Engines: Input polling timeout in ms (0=non-blocking)" },	//MOD RS
+	{ "mmvclock",					"0",	OPTION_BOOLEAN,						"Mephisto WB Engines: time control in emulated time (reproducible)" },	//MOD RS
+	{ "mmkeyscans",					"0",	0,									"Mephisto WB Engines: release a key after n ROM scans of its row (0=display handshake)" },	//MOD RS
+	{ "mmstopdeadline",				"0",	0,									"Mephisto WB Engines: ms from search stop to move, then send best move so far (0=off)" },	//MOD RS
+	{ "mmponder",					"0",	OPTION_BOOLEAN,						"Mephisto WB Engines: ponder on the expected reply at mmunlimited after hard (needs mmplysnaps)" },	//MOD RS
+	{ "mmsnapshot",					"0",	0,									"Mephisto WB Engines: state after boot for new (0=off, 1=per process, 2=also for next start)" },	//MOD RS
+	{ "mmplysnaps",					"32",	0,									"Mephisto WB Engines: states kept per ply for undo/remove (0=off, max 64)" },	//MOD RS
+	{ "mmepd",						"",		0,									"Mephisto WB Engines: EPD file for batch test" },		//MOD RS
+	{ "mmst",						"10",	0,									"Mephisto WB Engines: EPD/match seconds per position/move" },	//MOD RS
+	{ "mmjobs",						"1",	0,									"Mephisto WB Engines: EPD worker processes / concurrent match games" },	//MOD RS
+	{ "mmreport",					"epd_report.txt",	0,						"Mephisto WB Engines: EPD report file" },				//MOD RS
+	{ "mmmatch",					"",		0,									"Mephisto WB Engines: opponent module for an in-process match" },	//MOD RS
+	{ "mmgames",					"2",	0,									"Mephisto WB Engines: match number of games" },			//MOD RS
+	{ "mmpgn",						"match.pgn",	0,							"Mephisto WB Engines: match PGN file" },				//MOD RS
+	{ "mmtune",						"0",	OPTION_BOOLEAN,						"Mephisto WB Engines: probe the handshake waits and write hs_<module>.txt" },	//MOD RS
+	{ "mmforkserver",				"",		0,									"Mephisto WB Engines: boot once and fork an engine per connection on this socket" },	//MOD RS
+	{ "mmforkconnect",				"",		0,									"Mephisto WB Engines: connect stdin/stdout to a fork server socket" },	//MOD RS
 	{ NULL }
 };
 